@@ -1,5 +1,4 @@
 #define _POSIX_C_SOURCE 200809
-#include <assert.h>
 #include <cairo/cairo.h>
 #include <fcntl.h>
 #include <pango/pangocairo.h>
@@ -68,77 +67,187 @@ static const struct wl_buffer_listener buffer_listener = {
 	.release = buffer_release
 };
 
+static void buffer_create_cairo(struct buffer_pool *pool,
+		struct pool_buffer *buf) {
+	buf->data = (char *)pool->data + buf->offset;
+	buf->surface = cairo_image_surface_create_for_data(buf->data,
+			CAIRO_FORMAT_ARGB32, buf->width, buf->height, buf->width * 4);
+	buf->cairo = cairo_create(buf->surface);
+	buf->pango = pango_cairo_create_context(buf->cairo);
+}
+
+static void buffer_destroy_cairo(struct pool_buffer *buf) {
+	if (buf->cairo) {
+		cairo_destroy(buf->cairo);
+	}
+	if (buf->surface) {
+		cairo_surface_destroy(buf->surface);
+	}
+	if (buf->pango) {
+		g_object_unref(buf->pango);
+	}
+	buf->cairo = NULL;
+	buf->surface = NULL;
+	buf->pango = NULL;
+	buf->data = NULL;
+}
+
+/**
+ * Destroys the wl_buffer, keeping the part of the pool it was in.
+ */
+static void release_buffer(struct pool_buffer *buf) {
+	if (buf->buffer) {
+		wl_buffer_destroy(buf->buffer);
+		buf->buffer = NULL;
+	}
+	buffer_destroy_cairo(buf);
+	buf->width = buf->height = 0;
+	buf->busy = false;
+}
+
+static bool grow_pool(struct wl_shm *shm, struct buffer_pool *pool,
+		size_t size) {
+	if (!pool->pool) {
+		char *name;
+		int fd = create_pool_file(size, &name);
+		if (fd == -1) {
+			return false;
+		}
+		unlink(name);
+		free(name);
+		pool->fd = fd;
+		pool->pool = wl_shm_create_pool(shm, fd, size);
+	} else {
+		if (ftruncate(pool->fd, size) < 0) {
+			return false;
+		}
+		wl_shm_pool_resize(pool->pool, size);
+	}
+
+	void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			pool->fd, 0);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	if (pool->data) {
+		munmap(pool->data, pool->size);
+	}
+	pool->data = data;
+	pool->size = size;
+
+	// The buffers are mapped somewhere else now
+	for (size_t i = 0; i < pool->nbuffers; ++i) {
+		struct pool_buffer *buf = &pool->buffers[i];
+		if (buf->buffer) {
+			buffer_destroy_cairo(buf);
+			buffer_create_cairo(pool, buf);
+		}
+	}
+	return true;
+}
+
+/**
+ * Gives the buffer a part of the pool large enough for size bytes.
+ */
+static bool alloc_buffer(struct wl_shm *shm, struct buffer_pool *pool,
+		struct pool_buffer *buf, size_t size) {
+	bool busy = false;
+	for (size_t i = 0; i < pool->nbuffers; ++i) {
+		busy |= pool->buffers[i].busy;
+	}
+	if (!busy) {
+		// Nothing is in use, so the pool can be laid out from the start
+		for (size_t i = 0; i < pool->nbuffers; ++i) {
+			release_buffer(&pool->buffers[i]);
+			pool->buffers[i].offset = pool->buffers[i].size = 0;
+		}
+		pool->used = 0;
+	}
+
+	if (pool->used + size > pool->size) {
+		// Leave room for the other buffers at this size too
+		size_t pool_size = size * pool->nbuffers;
+		if (pool_size < pool->used + size) {
+			pool_size = pool->used + size;
+		}
+		if (!grow_pool(shm, pool, pool_size)) {
+			return false;
+		}
+	}
+	buf->offset = pool->used;
+	buf->size = size;
+	pool->used += size;
+	return true;
+}
+
 static struct pool_buffer *create_buffer(struct wl_shm *shm,
-		struct pool_buffer *buf, int32_t width, int32_t height,
-		uint32_t format) {
+		struct buffer_pool *pool, struct pool_buffer *buf,
+		int32_t width, int32_t height, uint32_t format) {
 	uint32_t stride = width * 4;
 	size_t size = stride * height;
 
-	char *name;
-	int fd = create_pool_file(size, &name);
-	assert(fd != -1);
-	void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-	struct wl_shm_pool *pool = wl_shm_create_pool(shm, fd, size);
-	buf->buffer = wl_shm_pool_create_buffer(pool, 0,
-			width, height, stride, format);
-	wl_shm_pool_destroy(pool);
-	close(fd);
-	unlink(name);
-	free(name);
+	release_buffer(buf);
+	if (buf->size < size && !alloc_buffer(shm, pool, buf, size)) {
+		return NULL;
+	}
 
-	buf->size = size;
+	buf->buffer = wl_shm_pool_create_buffer(pool->pool, buf->offset,
+			width, height, stride, format);
 	buf->width = width;
 	buf->height = height;
-	buf->data = data;
-	buf->surface = cairo_image_surface_create_for_data(data,
-			CAIRO_FORMAT_ARGB32, width, height, stride);
-	buf->cairo = cairo_create(buf->surface);
-	buf->pango = pango_cairo_create_context(buf->cairo);
+	buffer_create_cairo(pool, buf);
 
 	wl_buffer_add_listener(buf->buffer, &buffer_listener, buf);
 	return buf;
 }
 
-void destroy_buffer(struct pool_buffer *buffer) {
-	if (buffer->buffer) {
-		wl_buffer_destroy(buffer->buffer);
-	}
-	if (buffer->cairo) {
-		cairo_destroy(buffer->cairo);
-	}
-	if (buffer->surface) {
-		cairo_surface_destroy(buffer->surface);
+void init_buffer_pool(struct buffer_pool *pool, size_t nbuffers) {
+	memset(pool, 0, sizeof(struct buffer_pool));
+	pool->buffers = calloc(nbuffers, sizeof(struct pool_buffer));
+	pool->nbuffers = pool->buffers ? nbuffers : 0;
+}
+
+void finish_buffer_pool(struct buffer_pool *pool) {
+	for (size_t i = 0; i < pool->nbuffers; ++i) {
+		release_buffer(&pool->buffers[i]);
 	}
-	if (buffer->pango) {
-		g_object_unref(buffer->pango);
+	free(pool->buffers);
+	if (pool->pool) {
+		wl_shm_pool_destroy(pool->pool);
+		close(pool->fd);
 	}
-	if (buffer->data) {
-		munmap(buffer->data, buffer->size);
+	if (pool->data) {
+		munmap(pool->data, pool->size);
 	}
-	memset(buffer, 0, sizeof(struct pool_buffer));
+	memset(pool, 0, sizeof(struct buffer_pool));
 }
 
 struct pool_buffer *get_next_buffer(struct wl_shm *shm,
-		struct pool_buffer pool[static 2], uint32_t width, uint32_t height) {
+		struct buffer_pool *pool, uint32_t width, uint32_t height) {
 	struct pool_buffer *buffer = NULL;
 
-	for (size_t i = 0; i < 2; ++i) {
-		if (pool[i].busy) {
+	// Prefer a buffer which already has the right size
+	for (size_t i = 0; i < pool->nbuffers; ++i) {
+		struct pool_buffer *buf = &pool->buffers[i];
+		if (buf->busy) {
 			continue;
 		}
-		buffer = &pool[i];
+		if (buf->buffer && buf->width == width && buf->height == height) {
+			buffer = buf;
+			break;
+		}
+		if (!buffer) {
+			buffer = buf;
+		}
 	}
 
 	if (!buffer) {
 		return NULL;
 	}
 
-	if (buffer->width != width || buffer->height != height) {
-		destroy_buffer(buffer);
-	}
-
-	if (!buffer->buffer) {
-		if (!create_buffer(shm, buffer, width, height,
+	if (!buffer->buffer || buffer->width != width ||
+			buffer->height != height) {
+		if (!create_buffer(shm, pool, buffer, width, height,
 					WL_SHM_FORMAT_ARGB8888)) {
 			return NULL;
 		}
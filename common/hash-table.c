@@ -0,0 +1,168 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "hash-table.h"
+
+hash_table_t *create_hash_table(uint32_t hash(const void *key),
+		bool equal(const void *a, const void *b)) {
+	hash_table_t *table = malloc(sizeof(hash_table_t));
+	if (!table) {
+		return NULL;
+	}
+	table->capacity = 16;
+	table->length = 0;
+	table->buckets = calloc(table->capacity, sizeof(struct hash_entry *));
+	table->hash = hash;
+	table->equal = equal;
+	return table;
+}
+
+void hash_table_clear(hash_table_t *table) {
+	for (int i = 0; i < table->capacity; ++i) {
+		struct hash_entry *entry = table->buckets[i];
+		while (entry) {
+			struct hash_entry *next = entry->next;
+			free(entry);
+			entry = next;
+		}
+		table->buckets[i] = NULL;
+	}
+	table->length = 0;
+}
+
+void hash_table_free(hash_table_t *table) {
+	if (table == NULL) {
+		return;
+	}
+	hash_table_clear(table);
+	free(table->buckets);
+	free(table);
+}
+
+static struct hash_entry **hash_table_find(hash_table_t *table,
+		const void *key, uint32_t hash) {
+	struct hash_entry **entry = &table->buckets[hash & (table->capacity - 1)];
+	while (*entry) {
+		if ((*entry)->hash == hash && table->equal((*entry)->key, key)) {
+			break;
+		}
+		entry = &(*entry)->next;
+	}
+	return entry;
+}
+
+static void hash_table_grow(hash_table_t *table) {
+	int capacity = table->capacity * 2;
+	struct hash_entry **buckets = calloc(capacity, sizeof(struct hash_entry *));
+	if (!buckets) {
+		return;
+	}
+	for (int i = 0; i < table->capacity; ++i) {
+		struct hash_entry *entry = table->buckets[i];
+		while (entry) {
+			struct hash_entry *next = entry->next;
+			struct hash_entry **bucket = &buckets[entry->hash & (capacity - 1)];
+			entry->next = *bucket;
+			*bucket = entry;
+			entry = next;
+		}
+	}
+	free(table->buckets);
+	table->buckets = buckets;
+	table->capacity = capacity;
+}
+
+void *hash_table_get(hash_table_t *table, const void *key) {
+	struct hash_entry *entry = *hash_table_find(table, key, table->hash(key));
+	return entry ? entry->value : NULL;
+}
+
+void hash_table_set(hash_table_t *table, const void *key, void *value) {
+	uint32_t hash = table->hash(key);
+	struct hash_entry **slot = hash_table_find(table, key, hash);
+	if (*slot) {
+		(*slot)->key = key;
+		(*slot)->value = value;
+		return;
+	}
+	struct hash_entry *entry = malloc(sizeof(struct hash_entry));
+	if (!entry) {
+		return;
+	}
+	entry->key = key;
+	entry->value = value;
+	entry->hash = hash;
+	entry->next = NULL;
+	*slot = entry;
+	if (++table->length > table->capacity / 4 * 3) {
+		hash_table_grow(table);
+	}
+}
+
+void *hash_table_del(hash_table_t *table, const void *key) {
+	struct hash_entry **slot = hash_table_find(table, key, table->hash(key));
+	struct hash_entry *entry = *slot;
+	if (!entry) {
+		return NULL;
+	}
+	void *value = entry->value;
+	*slot = entry->next;
+	free(entry);
+	--table->length;
+	return value;
+}
+
+void hash_table_for_each(hash_table_t *table,
+		void (*f)(const void *key, void *value, void *data), void *data) {
+	for (int i = 0; i < table->capacity; ++i) {
+		struct hash_entry *entry = table->buckets[i];
+		while (entry) {
+			// Allow f to delete the current entry
+			struct hash_entry *next = entry->next;
+			f(entry->key, entry->value, data);
+			entry = next;
+		}
+	}
+}
+
+uint32_t hash_string(const void *key) {
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (const unsigned char *c = key; *c; ++c) {
+		hash ^= *c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+bool equal_string(const void *a, const void *b) {
+	return strcmp(a, b) == 0;
+}
+
+uint32_t hash_string_nocase(const void *key) {
+	uint32_t hash = 2166136261u;
+	for (const unsigned char *c = key; *c; ++c) {
+		hash ^= tolower(*c);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+bool equal_string_nocase(const void *a, const void *b) {
+	return strcasecmp(a, b) == 0;
+}
+
+uint32_t hash_uint(const void *key) {
+	uint32_t hash = (uint32_t)(uintptr_t)key;
+	hash ^= hash >> 16;
+	hash *= 0x7feb352d;
+	hash ^= hash >> 15;
+	hash *= 0x846ca68b;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+bool equal_uint(const void *a, const void *b) {
+	return a == b;
+}
@@ -2,33 +2,58 @@
 #include <limits.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <poll.h>
 #include <time.h>
 #include <unistd.h>
+#include "config.h"
+#if HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+#include "hash-table.h"
 #include "list.h"
 #include "log.h"
 #include "loop.h"
 
+#define LOOP_MAX_EVENTS 32
+
 struct loop_fd_event {
 	void (*callback)(int fd, short mask, void *data);
 	void *data;
+	int fd;
+	short mask;
+	short revents;
+	bool removed;
+#if !HAVE_EPOLL
+	int index; // in loop::fds
+#endif
 };
 
 struct loop_timer {
 	void (*callback)(void *data);
 	void *data;
 	struct timespec expiry;
+	int index; // in loop::timers
 };
 
 struct loop {
+#if HAVE_EPOLL
+	int epoll_fd;
+#else
 	struct pollfd *fds;
+	struct loop_fd_event **fd_events; // same order as fds
 	int fd_length;
 	int fd_capacity;
+#endif
+	hash_table_t *fd_table; // int -> struct loop_fd_event *
+	list_t *removed_fd_events; // freed once they can't be dispatched anymore
 
-	list_t *fd_events; // struct loop_fd_event
-	list_t *timers; // struct loop_timer
+	// Binary min-heap on the expiry, so the next timer is always first
+	struct loop_timer **timers;
+	int timer_length;
+	int timer_capacity;
 };
 
 struct loop *loop_create(void) {
@@ -37,74 +62,238 @@ struct loop *loop_create(void) {
 		sway_log(SWAY_ERROR, "Unable to allocate memory for loop");
 		return NULL;
 	}
+#if HAVE_EPOLL
+	loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (loop->epoll_fd == -1) {
+		sway_log_errno(SWAY_ERROR, "Unable to create epoll instance");
+		free(loop);
+		return NULL;
+	}
+#else
 	loop->fd_capacity = 10;
 	loop->fds = malloc(sizeof(struct pollfd) * loop->fd_capacity);
-	loop->fd_events = create_list();
-	loop->timers = create_list();
+	loop->fd_events = malloc(sizeof(struct loop_fd_event *) * loop->fd_capacity);
+#endif
+	loop->fd_table = create_hash_table(hash_uint, equal_uint);
+	loop->removed_fd_events = create_list();
+	loop->timer_capacity = 10;
+	loop->timers = malloc(sizeof(struct loop_timer *) * loop->timer_capacity);
 	return loop;
 }
 
+static void free_fd_event(const void *key, void *value, void *data) {
+	free(value);
+}
+
 void loop_destroy(struct loop *loop) {
-	list_free_items_and_destroy(loop->fd_events);
-	list_free_items_and_destroy(loop->timers);
+	hash_table_for_each(loop->fd_table, free_fd_event, NULL);
+	hash_table_free(loop->fd_table);
+	list_free_items_and_destroy(loop->removed_fd_events);
+	for (int i = 0; i < loop->timer_length; ++i) {
+		free(loop->timers[i]);
+	}
+	free(loop->timers);
+#if HAVE_EPOLL
+	close(loop->epoll_fd);
+#else
 	free(loop->fds);
+	free(loop->fd_events);
+#endif
 	free(loop);
 }
 
-void loop_poll(struct loop *loop) {
-	// Calculate next timer in ms
-	int ms = INT_MAX;
-	if (loop->timers->length) {
-		struct timespec now;
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		for (int i = 0; i < loop->timers->length; ++i) {
-			struct loop_timer *timer = loop->timers->items[i];
-			int timer_ms = (timer->expiry.tv_sec - now.tv_sec) * 1000;
-			timer_ms += (timer->expiry.tv_nsec - now.tv_nsec) / 1000000;
-			if (timer_ms < ms) {
-				ms = timer_ms;
-			}
+static bool timespec_before(const struct timespec *a,
+		const struct timespec *b) {
+	return a->tv_sec < b->tv_sec ||
+		(a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static void timer_heap_set(struct loop *loop, int index,
+		struct loop_timer *timer) {
+	loop->timers[index] = timer;
+	timer->index = index;
+}
+
+static void timer_heap_up(struct loop *loop, int index) {
+	struct loop_timer *timer = loop->timers[index];
+	while (index > 0) {
+		int parent = (index - 1) / 2;
+		if (!timespec_before(&timer->expiry, &loop->timers[parent]->expiry)) {
+			break;
 		}
+		timer_heap_set(loop, index, loop->timers[parent]);
+		index = parent;
 	}
-	if (ms < 0) {
-		ms = 0;
+	timer_heap_set(loop, index, timer);
+}
+
+static void timer_heap_down(struct loop *loop, int index) {
+	struct loop_timer *timer = loop->timers[index];
+	while (true) {
+		int child = 2 * index + 1;
+		if (child >= loop->timer_length) {
+			break;
+		}
+		if (child + 1 < loop->timer_length &&
+				timespec_before(&loop->timers[child + 1]->expiry,
+					&loop->timers[child]->expiry)) {
+			++child;
+		}
+		if (!timespec_before(&loop->timers[child]->expiry, &timer->expiry)) {
+			break;
+		}
+		timer_heap_set(loop, index, loop->timers[child]);
+		index = child;
 	}
+	timer_heap_set(loop, index, timer);
+}
 
-	poll(loop->fds, loop->fd_length, ms);
+static void timer_heap_remove(struct loop *loop, struct loop_timer *timer) {
+	int index = timer->index;
+	struct loop_timer *last = loop->timers[--loop->timer_length];
+	if (last == timer) {
+		return;
+	}
+	timer_heap_set(loop, index, last);
+	timer_heap_up(loop, index);
+	timer_heap_down(loop, last->index);
+}
 
-	// Dispatch fds
-	for (int i = 0; i < loop->fd_length; ++i) {
-		struct pollfd pfd = loop->fds[i];
-		struct loop_fd_event *event = loop->fd_events->items[i];
+/**
+ * Returns the time until the next timer expires in ms, rounded up so that the
+ * timer has expired when the loop wakes up, or -1 if there are no timers.
+ */
+static int next_timer_ms(struct loop *loop) {
+	if (loop->timer_length == 0) {
+		return -1;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	struct loop_timer *timer = loop->timers[0];
+	long long ns = (timer->expiry.tv_sec - now.tv_sec) * 1000000000LL +
+		(timer->expiry.tv_nsec - now.tv_nsec);
+	if (ns <= 0) {
+		return 0;
+	}
+	long long ms = (ns + 999999) / 1000000;
+	return ms > INT_MAX ? INT_MAX : ms;
+}
 
-		// Always send these events
-		unsigned events = pfd.events | POLLHUP | POLLERR;
+static void dispatch_timers(struct loop *loop) {
+	if (loop->timer_length == 0) {
+		return;
+	}
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	while (loop->timer_length > 0 &&
+			!timespec_before(&now, &loop->timers[0]->expiry)) {
+		struct loop_timer *timer = loop->timers[0];
+		timer_heap_remove(loop, timer);
+		timer->callback(timer->data);
+		free(timer);
+	}
+}
 
-		if (pfd.revents & events) {
-			event->callback(pfd.fd, pfd.revents, event->data);
+/**
+ * Calls the callbacks of the fds which are ready. A callback may remove any
+ * fd, so events are only freed after all of them have been dispatched.
+ */
+static void dispatch_fd_events(struct loop *loop,
+		struct loop_fd_event **ready, int length) {
+	for (int i = 0; i < length; ++i) {
+		struct loop_fd_event *event = ready[i];
+		// Always send these events
+		short events = event->mask | POLLHUP | POLLERR;
+		if (!event->removed && (event->revents & events)) {
+			event->callback(event->fd, event->revents, event->data);
 		}
 	}
+	for (int i = 0; i < loop->removed_fd_events->length; ++i) {
+		free(loop->removed_fd_events->items[i]);
+	}
+	loop->removed_fd_events->length = 0;
+}
 
-	// Dispatch timers
-	if (loop->timers->length) {
-		struct timespec now;
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		for (int i = 0; i < loop->timers->length; ++i) {
-			struct loop_timer *timer = loop->timers->items[i];
-			bool expired = timer->expiry.tv_sec < now.tv_sec ||
-				(timer->expiry.tv_sec == now.tv_sec &&
-				 timer->expiry.tv_nsec < now.tv_nsec);
-			if (expired) {
-				timer->callback(timer->data);
-				loop_remove_timer(loop, timer);
-				--i;
-			}
+#if HAVE_EPOLL
+static uint32_t mask_to_epoll(short mask) {
+	uint32_t events = 0;
+	if (mask & POLLIN) {
+		events |= EPOLLIN;
+	}
+	if (mask & POLLOUT) {
+		events |= EPOLLOUT;
+	}
+	if (mask & POLLPRI) {
+		events |= EPOLLPRI;
+	}
+	return events;
+}
+
+static short epoll_to_mask(uint32_t events) {
+	short mask = 0;
+	if (events & EPOLLIN) {
+		mask |= POLLIN;
+	}
+	if (events & EPOLLOUT) {
+		mask |= POLLOUT;
+	}
+	if (events & EPOLLPRI) {
+		mask |= POLLPRI;
+	}
+	if (events & EPOLLHUP) {
+		mask |= POLLHUP;
+	}
+	if (events & EPOLLERR) {
+		mask |= POLLERR;
+	}
+	return mask;
+}
+
+void loop_poll(struct loop *loop) {
+	struct epoll_event events[LOOP_MAX_EVENTS];
+	int n = epoll_wait(loop->epoll_fd, events, LOOP_MAX_EVENTS,
+			next_timer_ms(loop));
+
+	struct loop_fd_event *ready[LOOP_MAX_EVENTS];
+	for (int i = 0; i < n; ++i) {
+		ready[i] = events[i].data.ptr;
+		ready[i]->revents = epoll_to_mask(events[i].events);
+	}
+	dispatch_fd_events(loop, ready, n > 0 ? n : 0);
+
+	dispatch_timers(loop);
+}
+#else
+void loop_poll(struct loop *loop) {
+	int n = poll(loop->fds, loop->fd_length, next_timer_ms(loop));
+
+	// Callbacks may change fds, so collect the ready events first
+	struct loop_fd_event *ready[LOOP_MAX_EVENTS];
+	int length = 0;
+	for (int i = 0; i < loop->fd_length && n > 0; ++i) {
+		if (loop->fds[i].revents == 0) {
+			continue;
+		}
+		--n;
+		loop->fd_events[i]->revents = loop->fds[i].revents;
+		ready[length++] = loop->fd_events[i];
+		if (length == LOOP_MAX_EVENTS) {
+			dispatch_fd_events(loop, ready, length);
+			length = 0;
 		}
 	}
+	dispatch_fd_events(loop, ready, length);
+
+	dispatch_timers(loop);
 }
+#endif
 
 void loop_add_fd(struct loop *loop, int fd, short mask,
 		void (*callback)(int fd, short mask, void *data), void *data) {
+	if (hash_table_get(loop->fd_table, (void *)(uintptr_t)fd)) {
+		sway_log(SWAY_ERROR, "fd %d is already in the loop", fd);
+		return;
+	}
 	struct loop_fd_event *event = calloc(1, sizeof(struct loop_fd_event));
 	if (!event) {
 		sway_log(SWAY_ERROR, "Unable to allocate memory for event");
@@ -112,17 +301,33 @@ void loop_add_fd(struct loop *loop, int fd, short mask,
 	}
 	event->callback = callback;
 	event->data = data;
-	list_add(loop->fd_events, event);
-
-	struct pollfd pfd = {fd, mask, 0};
+	event->fd = fd;
+	event->mask = mask;
 
+#if HAVE_EPOLL
+	struct epoll_event ev = {
+		.events = mask_to_epoll(mask),
+		.data.ptr = event,
+	};
+	if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		sway_log_errno(SWAY_ERROR, "Unable to add fd %d to the loop", fd);
+		free(event);
+		return;
+	}
+#else
 	if (loop->fd_length == loop->fd_capacity) {
 		loop->fd_capacity += 10;
 		loop->fds = realloc(loop->fds,
 				sizeof(struct pollfd) * loop->fd_capacity);
+		loop->fd_events = realloc(loop->fd_events,
+				sizeof(struct loop_fd_event *) * loop->fd_capacity);
 	}
 
-	loop->fds[loop->fd_length++] = pfd;
+	event->index = loop->fd_length++;
+	loop->fds[event->index] = (struct pollfd){fd, mask, 0};
+	loop->fd_events[event->index] = event;
+#endif
+	hash_table_set(loop->fd_table, (void *)(uintptr_t)fd, event);
 }
 
 struct loop_timer *loop_add_timer(struct loop *loop, int ms,
@@ -145,34 +350,44 @@ struct loop_timer *loop_add_timer(struct loop *loop, int ms,
 	}
 	timer->expiry.tv_nsec += nsec;
 
-	list_add(loop->timers, timer);
+	if (loop->timer_length == loop->timer_capacity) {
+		loop->timer_capacity *= 2;
+		loop->timers = realloc(loop->timers,
+				sizeof(struct loop_timer *) * loop->timer_capacity);
+	}
+	loop->timers[loop->timer_length] = timer;
+	timer_heap_up(loop, loop->timer_length++);
 
 	return timer;
 }
 
 bool loop_remove_fd(struct loop *loop, int fd) {
-	for (int i = 0; i < loop->fd_length; ++i) {
-		if (loop->fds[i].fd == fd) {
-			free(loop->fd_events->items[i]);
-			list_del(loop->fd_events, i);
-
-			loop->fd_length--;
-			memmove(&loop->fds[i], &loop->fds[i + 1],
-					sizeof(struct pollfd) * (loop->fd_length - i));
+	struct loop_fd_event *event =
+		hash_table_del(loop->fd_table, (void *)(uintptr_t)fd);
+	if (!event) {
+		return false;
+	}
 
-			return true;
-		}
+#if HAVE_EPOLL
+	// Fails if the fd has been closed already, which removed it anyway
+	epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#else
+	// Move the last fd into the gap
+	int last = --loop->fd_length;
+	if (event->index != last) {
+		loop->fds[event->index] = loop->fds[last];
+		loop->fd_events[event->index] = loop->fd_events[last];
+		loop->fd_events[event->index]->index = event->index;
 	}
-	return false;
+#endif
+
+	event->removed = true;
+	list_add(loop->removed_fd_events, event);
+	return true;
 }
 
 bool loop_remove_timer(struct loop *loop, struct loop_timer *timer) {
-	for (int i = 0; i < loop->timers->length; ++i) {
-		if (loop->timers->items[i] == timer) {
-			list_del(loop->timers, i);
-			free(timer);
-			return true;
-		}
-	}
-	return false;
+	timer_heap_remove(loop, timer);
+	free(timer);
+	return true;
 }
@@ -0,0 +1,57 @@
+#ifndef _SWAY_HASH_TABLE_H
+#define _SWAY_HASH_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct hash_entry {
+	const void *key;
+	void *value;
+	uint32_t hash;
+	struct hash_entry *next;
+};
+
+typedef struct {
+	int capacity;
+	int length;
+	struct hash_entry **buckets;
+	uint32_t (*hash)(const void *key);
+	bool (*equal)(const void *a, const void *b);
+} hash_table_t;
+
+/**
+ * Create a hash table using the given hash and equality functions. Keys are
+ * not copied, so they must outlive their entry in the table.
+ */
+hash_table_t *create_hash_table(uint32_t hash(const void *key),
+		bool equal(const void *a, const void *b));
+
+void hash_table_free(hash_table_t *table);
+
+// Return the value stored for key or NULL if there is none.
+void *hash_table_get(hash_table_t *table, const void *key);
+
+// Insert or replace the value stored for key.
+void hash_table_set(hash_table_t *table, const void *key, void *value);
+
+// Remove the entry for key and return its value, or NULL if there was none.
+void *hash_table_del(hash_table_t *table, const void *key);
+
+void hash_table_clear(hash_table_t *table);
+
+void hash_table_for_each(hash_table_t *table,
+		void (*f)(const void *key, void *value, void *data), void *data);
+
+// Hash and equality functions for NUL-terminated string keys
+uint32_t hash_string(const void *key);
+bool equal_string(const void *a, const void *b);
+
+// Hash and equality functions for ASCII case-insensitive string keys
+uint32_t hash_string_nocase(const void *key);
+bool equal_string_nocase(const void *a, const void *b);
+
+// Hash and equality functions for integer keys cast with (void *)(uintptr_t)
+uint32_t hash_uint(const void *key);
+bool equal_uint(const void *a, const void *b);
+
+#endif
@@ -28,7 +28,8 @@ void loop_destroy(struct loop *loop);
 void loop_poll(struct loop *loop);
 
 /**
- * Add a file descriptor to the loop.
+ * Add a file descriptor to the loop. A file descriptor can only be in the loop
+ * once.
  */
 void loop_add_fd(struct loop *loop, int fd, short mask,
 		void (*func)(int fd, short mask, void *data), void *data);
@@ -47,7 +48,11 @@ struct loop_timer *loop_add_timer(struct loop *loop, int ms,
 bool loop_remove_fd(struct loop *loop, int fd);
 
 /**
- * Remove a timer from the loop.
+ * Remove a timer from the loop and free it.
+ *
+ * The timer must still be in the loop. It leaves the loop when it expires and
+ * is freed after its callback, so it must not be passed here from that
+ * callback or afterwards.
  */
 bool loop_remove_timer(struct loop *loop, struct loop_timer *timer);
 
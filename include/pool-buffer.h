@@ -13,12 +13,33 @@ struct pool_buffer {
 	PangoContext *pango;
 	uint32_t width, height;
 	void *data;
-	size_t size;
+	size_t offset, size; // the part of the pool the buffer may use
 	bool busy;
 };
 
+/**
+ * The buffers of a surface. They are sub-allocated from a single shm pool,
+ * which grows when a buffer doesn't fit anymore, and keep their part of the
+ * pool across size changes as long as they fit in it.
+ */
+struct buffer_pool {
+	struct wl_shm_pool *pool;
+	int fd; // only valid once the pool is created
+	void *data;
+	size_t size, used;
+
+	struct pool_buffer *buffers;
+	size_t nbuffers;
+};
+
+void init_buffer_pool(struct buffer_pool *pool, size_t nbuffers);
+void finish_buffer_pool(struct buffer_pool *pool);
+
+/**
+ * Returns a buffer of the given size which the compositor isn't using, or NULL
+ * if all of them are busy or it can't be allocated.
+ */
 struct pool_buffer *get_next_buffer(struct wl_shm *shm,
-		struct pool_buffer pool[static 2], uint32_t width, uint32_t height);
-void destroy_buffer(struct pool_buffer *buffer);
+		struct buffer_pool *pool, uint32_t width, uint32_t height);
 
 #endif
@@ -5,6 +5,7 @@
 #include "config.h"
 
 struct sway_container;
+struct cmd_program;
 
 typedef struct cmd_results *sway_cmd(int argc, char **argv);
 
@@ -57,6 +58,18 @@ struct cmd_handler *find_handler(char *line, struct cmd_handler *cmd_handlers,
  */
 list_t *execute_command(char *command,  struct sway_seat *seat,
 		struct sway_container *con);
+/**
+ * Executes a command like execute_command, but keeps the parsed command in
+ * *program so later calls with the same program skip parsing it again.
+ *
+ * The parsed command is discarded when a variable is set. Commands which can't
+ * be parsed ahead of time (such as ones with criteria using __focused__) are
+ * always executed with execute_command.
+ */
+list_t *execute_cached_command(struct cmd_program **program, char *command,
+		struct sway_seat *seat, struct sway_container *con);
+
+void cmd_program_unref(struct cmd_program *program);
 /**
  * Parse and handles a command during config file loading.
  *
@@ -131,11 +144,13 @@ sway_cmd cmd_font;
 sway_cmd cmd_for_window;
 sway_cmd cmd_force_display_urgency_hint;
 sway_cmd cmd_force_focus_wrapping;
+sway_cmd cmd_frame_throttle;
 sway_cmd cmd_fullscreen;
 sway_cmd cmd_gaps;
 sway_cmd cmd_hide_edge_borders;
 sway_cmd cmd_include;
 sway_cmd cmd_input;
+sway_cmd cmd_interactive_update_rate;
 sway_cmd cmd_seat;
 sway_cmd cmd_ipc;
 sway_cmd cmd_kill;
@@ -201,6 +216,7 @@ sway_cmd bar_cmd_position;
 sway_cmd bar_cmd_separator_symbol;
 sway_cmd bar_cmd_status_command;
 sway_cmd bar_cmd_status_edge_padding;
+sway_cmd bar_cmd_status_min_interval;
 sway_cmd bar_cmd_status_padding;
 sway_cmd bar_cmd_pango_markup;
 sway_cmd bar_cmd_strip_workspace_numbers;
@@ -257,6 +273,7 @@ sway_cmd output_cmd_background;
 sway_cmd output_cmd_disable;
 sway_cmd output_cmd_dpms;
 sway_cmd output_cmd_enable;
+sway_cmd output_cmd_frame_throttle;
 sway_cmd output_cmd_mode;
 sway_cmd output_cmd_position;
 sway_cmd output_cmd_scale;
@@ -7,6 +7,7 @@
 #include <wlr/types/wlr_box.h>
 #include <xkbcommon/xkbcommon.h>
 #include "../include/config.h"
+#include "hash-table.h"
 #include "list.h"
 #include "swaynag.h"
 #include "tree/container.h"
@@ -50,6 +51,7 @@ struct sway_binding {
 	list_t *keys; // sorted in ascending order
 	uint32_t modifiers;
 	char *command;
+	struct cmd_program *program; // parsed command, see execute_cached_command
 };
 
 /**
@@ -79,6 +81,9 @@ struct sway_mode {
 	list_t *keycode_bindings;
 	list_t *mouse_bindings;
 	bool pango;
+	// Lookup tables built from the binding lists, see keyboard.c
+	hash_table_t *keysym_table;
+	hash_table_t *keycode_table;
 };
 
 struct input_config_mapped_from_region {
@@ -176,6 +181,7 @@ struct output_config {
 	char *background_option;
 	char *background_fallback;
 	enum config_dpms dpms_state;
+	int frame_throttle; // frame rate of unfocused views, 0 for unthrottled
 };
 
 /**
@@ -241,6 +247,7 @@ struct bar_config {
 	pid_t pid;
 	int status_padding;
 	int status_edge_padding;
+	int status_min_interval;
 	struct {
 		char *background;
 		char *statusline;
@@ -398,6 +405,7 @@ struct sway_config {
 	char *swaynag_command;
 	struct swaynag_instance swaynag_config_errors;
 	list_t *symbols;
+	uint32_t symbols_generation; // bumped whenever a variable is set
 	list_t *modes;
 	list_t *bars;
 	list_t *cmd_queue;
@@ -406,6 +414,7 @@ struct sway_config {
 	list_t *input_configs;
 	list_t *seat_configs;
 	list_t *criteria;
+	struct criteria_index *criteria_index;
 	list_t *no_focus;
 	list_t *active_bar_modifiers;
 	struct sway_mode *current_mode;
@@ -449,6 +458,10 @@ struct sway_config {
 	bool tiling_drag;
 	int tiling_drag_threshold;
 
+	// Rate in Hz at which moving and resizing with the mouse is applied. 0
+	// applies every motion, -1 uses the refresh rate of the cursor's output.
+	int interactive_update_rate;
+
 	bool smart_gaps;
 	int gaps_inner;
 	struct side_gaps gaps_outer;
@@ -591,6 +604,12 @@ void apply_output_config_to_outputs(struct output_config *oc);
 
 void reset_outputs(void);
 
+/**
+ * Forgets the backgrounds given to swaybg, and respawns it once outputs are
+ * configured again and the current event is handled.
+ */
+void reset_swaybg(void);
+
 void free_output_config(struct output_config *oc);
 
 int workspace_output_cmp_workspace(const void *a, const void *b);
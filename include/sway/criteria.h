@@ -2,6 +2,7 @@
 #define _SWAY_CRITERIA_H
 
 #include <pcre.h>
+#include <stdint.h>
 #include "config.h"
 #include "list.h"
 #include "tree/view.h"
@@ -14,30 +15,41 @@ enum criteria_type {
 	CT_NO_FOCUS                = 1 << 4,
 };
 
+struct pattern {
+	pcre *regex;
+	pcre_extra *extra; // JIT compiled code, if available
+	char *literal; // set if the regex only matches this exact string
+};
+
 struct criteria {
 	enum criteria_type type;
+	int order; // position in config->criteria
+	uintptr_t serial; // unique for the lifetime of the process
 	char *raw; // entire criteria string (for logging)
 	char *cmdlist;
+	struct cmd_program *program; // parsed cmdlist, see execute_cached_command
 	char *target; // workspace or output name for `assign` criteria
 
-	pcre *title;
-	pcre *shell;
-	pcre *app_id;
-	pcre *con_mark;
+	struct pattern *title;
+	struct pattern *shell;
+	struct pattern *app_id;
+	struct pattern *con_mark;
 	uint32_t con_id; // internal ID
 #if HAVE_XWAYLAND
-	pcre *class;
+	struct pattern *class;
 	uint32_t id; // X11 window ID
-	pcre *instance;
-	pcre *window_role;
+	struct pattern *instance;
+	struct pattern *window_role;
 	enum atom_name window_type;
 #endif
 	bool floating;
 	bool tiling;
 	char urgent; // 'l' for latest or 'o' for oldest
-	pcre *workspace;
+	struct pattern *workspace;
 };
 
+struct criteria_index;
+
 bool criteria_is_empty(struct criteria *criteria);
 
 void criteria_destroy(struct criteria *criteria);
@@ -52,6 +64,30 @@ void criteria_destroy(struct criteria *criteria);
  */
 struct criteria *criteria_parse(char *raw, char **error);
 
+/**
+ * Like criteria_parse, but reuses the result if the same criteria string was
+ * parsed recently. The criteria is owned by the cache and is only guaranteed to
+ * be valid until the next call.
+ */
+struct criteria *criteria_parse_cached(char *raw, char **error);
+
+struct criteria_cache_stats {
+	size_t hits, misses;
+	int size, capacity;
+};
+
+void criteria_cache_get_stats(struct criteria_cache_stats *stats);
+
+struct criteria_index *criteria_index_create(void);
+
+void criteria_index_destroy(struct criteria_index *index);
+
+/**
+ * Append the criteria to config->criteria and add it to the index used by
+ * criteria_for_view.
+ */
+void criteria_add(struct criteria *criteria);
+
 /**
  * Compile a list of criterias matching the given view.
  *
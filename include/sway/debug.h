@@ -7,6 +7,7 @@ struct sway_debug {
 	bool render_tree;      // Render the tree overlay
 	bool txn_timings;      // Log verbose messages about transactions
 	bool txn_wait;         // Always wait for the timeout before applying
+	bool validate_index;   // Check tree index lookups against a tree walk
 
 	enum {
 		DAMAGE_DEFAULT,    // Default behaviour
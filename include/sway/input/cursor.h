@@ -72,6 +72,11 @@ struct sway_cursor *sway_cursor_create(struct sway_seat *seat);
 void cursor_rebase(struct sway_cursor *cursor);
 void cursor_rebase_all(void);
 
+/**
+ * Rebase the cursors which are within the region, in layout coordinates.
+ */
+void cursor_rebase_region(pixman_region32_t *region);
+
 void cursor_handle_activity(struct sway_cursor *cursor);
 void cursor_unhide(struct sway_cursor *cursor);
 int cursor_get_timeout(struct sway_cursor *cursor);
@@ -3,6 +3,7 @@
 #include <libinput.h>
 #include <wlr/types/wlr_input_inhibitor.h>
 #include <wlr/types/wlr_virtual_keyboard_v1.h>
+#include "sway/input/latency.h"
 #include "sway/server.h"
 #include "sway/config.h"
 #include "list.h"
@@ -12,6 +13,7 @@ struct sway_input_device {
 	struct wlr_input_device *wlr_device;
 	struct wl_list link;
 	struct wl_listener device_destroy;
+	struct sway_input_latency latency;
 };
 
 struct sway_input_manager {
@@ -33,6 +35,12 @@ bool input_manager_has_focus(struct sway_node *node);
 
 void input_manager_set_focus(struct sway_node *node);
 
+/**
+ * Called by the tree when children are attached to or detached from the node,
+ * see seat_node_children_changed.
+ */
+void input_manager_node_children_changed(struct sway_node *node);
+
 void input_manager_configure_xcursor(void);
 
 void input_manager_apply_input_config(struct input_config *input_config);
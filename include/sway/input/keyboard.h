@@ -26,6 +26,13 @@ const char *get_modifier_name_by_mask(uint32_t modifier);
  */
 int get_modifier_names(const char **names, uint32_t modifier_masks);
 
+/**
+ * Drop the binding lookup tables of a mode. This must be called whenever its
+ * keysym or keycode bindings change; the tables are rebuilt on the next key
+ * event.
+ */
+void sway_mode_clear_binding_tables(struct sway_mode *mode);
+
 struct sway_shortcut_state {
 	/**
 	 * A list of pressed key ids (either keysyms or keycodes),
@@ -73,4 +80,11 @@ void sway_keyboard_configure(struct sway_keyboard *keyboard);
 void sway_keyboard_destroy(struct sway_keyboard *keyboard);
 
 void sway_keyboard_disarm_key_repeat(struct sway_keyboard *keyboard);
+
+/**
+ * Drops the unused compiled keymaps and the XKB context, so that keymaps are
+ * compiled again from the XKB files. Keymaps still in use are freed once the
+ * last keyboard using them releases them.
+ */
+void sway_keyboard_flush_keymap_cache(void);
 #endif
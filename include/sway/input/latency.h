@@ -0,0 +1,84 @@
+#ifndef _SWAY_INPUT_LATENCY_H
+#define _SWAY_INPUT_LATENCY_H
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Latencies are counted in 1ms buckets, anything longer is discarded
+#define INPUT_LATENCY_MAX_MSEC 1000
+
+// Number of input events a frame or a transaction can carry
+#define INPUT_LATENCY_CARRIED 16
+
+struct sway_input_device;
+struct sway_output;
+
+/**
+ * The time it took for input events of a device to be presented on an output
+ * by a frame containing the damage they caused.
+ */
+struct sway_input_latency {
+	uint32_t histogram[INPUT_LATENCY_MAX_MSEC];
+	uint32_t count;
+	uint32_t max;
+};
+
+/**
+ * Input events carried along with the work they caused, such as damage or a
+ * transaction, until that work is presented. When full, further events are
+ * dropped.
+ */
+struct input_latency_marks {
+	uint64_t serials[INPUT_LATENCY_CARRIED];
+	size_t len;
+};
+
+/**
+ * Start handling an input event from the device which happened at time_msec,
+ * in CLOCK_MONOTONIC milliseconds like libinput event times. Damage and
+ * transactions until input_latency_end are attributed to the event. If the
+ * event doesn't cause any, it isn't counted.
+ */
+void input_latency_begin(struct sway_input_device *device, uint32_t time_msec);
+
+/**
+ * Resume work caused by earlier input events, such as applying a transaction,
+ * until input_latency_end.
+ */
+void input_latency_resume(const struct input_latency_marks *marks);
+
+void input_latency_end(void);
+
+/**
+ * Add the input events being handled to marks, if there are any.
+ */
+void input_latency_carry(struct input_latency_marks *marks);
+
+void input_latency_merge(struct input_latency_marks *dest,
+		const struct input_latency_marks *src);
+
+/**
+ * Called when the output is damaged. The input events being handled are
+ * presented by the next frame of the output.
+ */
+void input_latency_damage(struct sway_output *output);
+
+/**
+ * Called when a frame has been rendered on the output.
+ */
+void input_latency_frame(struct sway_output *output);
+
+void input_latency_present(struct sway_output *output,
+		const struct timespec *when);
+
+// Forget the pending input events of a device which is being destroyed
+void input_latency_device_destroy(struct sway_input_device *device);
+
+/**
+ * Get the latency in milliseconds below which the given fraction of the
+ * recorded latencies are.
+ */
+uint32_t input_latency_percentile(const struct sway_input_latency *latency,
+		double fraction);
+
+#endif
@@ -5,6 +5,7 @@
 #include <wlr/types/wlr_seat.h>
 #include <wlr/util/edges.h>
 #include "sway/input/input-manager.h"
+#include "hash-table.h"
 
 struct sway_seat;
 
@@ -21,6 +22,8 @@ struct sway_seatop_impl {
 	void (*render)(struct sway_seat *seat, struct sway_output *output,
 			pixman_region32_t *damage);
 	bool allow_set_cursor;
+	// Apply motion at most at the interactive_update_rate
+	bool coalesce_motion;
 };
 
 struct sway_seat_device {
@@ -35,6 +38,19 @@ struct sway_seat_node {
 	struct sway_node *node;
 
 	struct wl_list link; // sway_seat::focus_stack
+	int64_t focus_order; // higher for nodes closer to the top of the stack
+
+	// What the focus stack says about the node's children, kept up to date as
+	// nodes are focused and moved around the tree so that the focus-inactive
+	// queries don't have to search for it. Children without a seat node, such
+	// as one being destroyed, don't count.
+	struct sway_seat_node *active_child; // child with the highest focus_order
+	struct sway_seat_node *focus_child; // child with the highest subtree_order
+	struct sway_seat_node *focus_view_child; // same, for view_order
+	// Highest focus_order in the node's subtree, the node itself included
+	int64_t subtree_order;
+	// Highest focus_order of a view in the subtree, INT64_MIN if there is none
+	int64_t view_order;
 
 	struct wl_listener destroy;
 };
@@ -58,6 +74,8 @@ struct sway_seat {
 
 	bool has_focus;
 	struct wl_list focus_stack; // list of containers in focus order
+	hash_table_t *focus_nodes; // node id -> sway_seat_node
+	int64_t focus_order_top, focus_order_bottom;
 	struct sway_workspace *workspace;
 	char *prev_workspace_name; // for workspace back_and_forth
 
@@ -75,6 +93,14 @@ struct sway_seat {
 	const struct sway_seatop_impl *seatop_impl;
 	void *seatop_data;
 
+	// Motion not yet passed to a seatop which coalesces it
+	double seatop_dx, seatop_dy;
+	uint32_t seatop_motion_time; // time of the latest held back motion
+	bool seatop_motion_pending;
+	uint32_t seatop_motion_msec; // when motion was last passed on
+	struct input_latency_marks seatop_motion_latency; // of held back motion
+	struct wl_event_source *seatop_motion_timer;
+
 	uint32_t last_button_serial;
 
 	struct wl_listener focus_destroy;
@@ -172,6 +198,12 @@ struct sway_container *seat_get_focus_inactive_view(struct sway_seat *seat,
 struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
 		struct sway_node *parent);
 
+/**
+ * Update what the seat knows about the focus order below the node, after
+ * children were attached to or detached from it.
+ */
+void seat_node_children_changed(struct sway_seat *seat, struct sway_node *node);
+
 /**
  * Iterate over the focus-inactive children of the container calling the
  * function on each.
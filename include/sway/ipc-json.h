@@ -6,6 +6,8 @@
 
 json_object *ipc_json_get_version(void);
 
+json_object *ipc_json_get_stats(void);
+
 json_object *ipc_json_describe_disabled_output(struct sway_output *o);
 json_object *ipc_json_describe_node(struct sway_node *node);
 json_object *ipc_json_describe_node_recursive(struct sway_node *node);
@@ -6,6 +6,7 @@
 #include <wlr/types/wlr_box.h>
 #include <wlr/types/wlr_output.h>
 #include "config.h"
+#include "sway/input/latency.h"
 #include "sway/tree/node.h"
 #include "sway/tree/view.h"
 
@@ -17,6 +18,8 @@ struct sway_output_state {
 	struct sway_workspace *active_workspace;
 };
 
+#define OUTPUT_HIT_GRID_SIZE 8
+
 struct sway_output {
 	struct sway_node node;
 	struct wlr_output *wlr_output;
@@ -28,6 +31,9 @@ struct sway_output {
 
 	struct timespec last_frame;
 	struct wlr_output_damage *damage;
+	// Input events which caused the pending damage, and the ones shown by
+	// the frame waiting to be presented
+	struct input_latency_marks input_latency_damage, input_latency_frame;
 
 	int lx, ly; // layout coords
 	int width, height; // transformed buffer size
@@ -37,8 +43,24 @@ struct sway_output {
 
 	struct sway_output_state current;
 
+	// Runs a custom swaybg_command for this output
 	struct wl_client *swaybg_client;
 
+	int frame_throttle; // frame rate of unfocused views, 0 if unthrottled
+	struct wl_event_source *frame_throttle_timer;
+
+	/**
+	 * The floating containers overlapping each cell of a grid over the
+	 * output, topmost first, so that hit-testing doesn't need to check every
+	 * floating container. It's rebuilt when a transaction is applied and only
+	 * used while no node has been marked dirty since.
+	 */
+	struct {
+		list_t *cells[OUTPUT_HIT_GRID_SIZE * OUTPUT_HIT_GRID_SIZE];
+		uint64_t serial; // root->dirty_serial when built, 0 if never built
+		struct sway_seat *seat; // seat whose focus decided visibility
+	} hit_grid;
+
 	struct wl_listener destroy;
 	struct wl_listener mode;
 	struct wl_listener transform;
@@ -67,6 +89,17 @@ struct sway_output *output_get_in_direction(struct sway_output *reference,
 void output_add_workspace(struct sway_output *output,
 		struct sway_workspace *workspace);
 
+void output_update_hit_grid(struct sway_output *output);
+
+/**
+ * Find the floating containers which may contain the given layout coordinates,
+ * topmost first. Returns false if the hit grid is out of date, in which case
+ * the floating containers of all visible workspaces need to be checked.
+ * Otherwise *floaters is set, or is NULL if there are none.
+ */
+bool output_get_floating_at(struct sway_output *output, double lx, double ly,
+		list_t **floaters);
+
 typedef void (*sway_surface_iterator_func_t)(struct sway_output *output,
 	struct wlr_surface *surface, struct wlr_box *box, float rotation,
 	void *user_data);
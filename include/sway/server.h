@@ -67,6 +67,14 @@ struct sway_server {
 	struct wlr_pointer_constraints_v1 *pointer_constraints;
 	struct wl_listener pointer_constraint;
 
+	// The bundled swaybg draws the background of every output
+	struct wl_client *swaybg_client;
+	struct wl_listener swaybg_client_destroy;
+	// Its arguments, "output path mode fallback" for each output given a
+	// background, including outputs which are gone for now
+	list_t *swaybg_args;
+	struct wl_event_source *swaybg_idle;
+
 	size_t txn_timeout_ms;
 	list_t *transactions;
 	list_t *dirty_nodes;
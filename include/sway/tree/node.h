@@ -47,6 +47,17 @@ struct sway_node {
 
 void node_init(struct sway_node *node, enum sway_node_type type, void *thing);
 
+/**
+ * Remove the node from the ID index. Must be called before the node is freed.
+ */
+void node_finish(struct sway_node *node);
+
+/**
+ * Find a node by its ID. Returns NULL if there is no such node or if it is
+ * being destroyed.
+ */
+struct sway_node *node_from_id(size_t id);
+
 const char *node_type_to_str(enum sway_node_type type);
 
 /**
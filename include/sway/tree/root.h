@@ -7,6 +7,7 @@
 #include "sway/tree/container.h"
 #include "sway/tree/node.h"
 #include "config.h"
+#include "hash-table.h"
 #include "list.h"
 
 extern struct sway_root *root;
@@ -21,6 +22,12 @@ struct sway_root {
 #endif
 	struct wl_list drag_icons; // sway_drag_icon::link
 
+	// Mapped urgent views, ordered from oldest to latest urgency
+	struct wl_list urgent_views; // sway_view::urgent_link
+
+	// Bumped whenever a node is marked dirty, see output::hit_grid
+	uint64_t dirty_serial;
+
 	struct wlr_texture *debug_tree;
 
 	// Includes disabled outputs
@@ -37,6 +44,11 @@ struct sway_root {
 
 	struct sway_container *fullscreen_global;
 
+	// Indexes of containers and workspaces which aren't being destroyed
+	hash_table_t *marks; // char * -> struct sway_container
+	hash_table_t *workspace_names; // char * -> list_t of sway_workspace
+	hash_table_t *workspace_numbers; // char * -> list_t of sway_workspace
+
 	struct {
 		struct wl_signal new_node;
 	} events;
@@ -44,6 +56,14 @@ struct sway_root {
 
 struct sway_root *root_create(void);
 
+/**
+ * Add or remove a workspace from the name and number indexes. A workspace must
+ * be removed before it is renamed and added again afterwards.
+ */
+void root_index_workspace(struct sway_workspace *ws);
+
+void root_unindex_workspace(struct sway_workspace *ws);
+
 void root_destroy(struct sway_root *root);
 
 /**
@@ -7,6 +7,7 @@
 #if HAVE_XWAYLAND
 #include <wlr/xwayland.h>
 #endif
+#include "hash-table.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
 
@@ -81,6 +82,12 @@ struct sway_view {
 	struct timespec urgent;
 	bool allow_request_urgent;
 	struct wl_event_source *urgent_timer;
+	struct wl_list urgent_link; // sway_root::urgent_views
+
+	// Frame rate when the view isn't focused: 0 to use the output's setting,
+	// -1 to never throttle it
+	int frame_throttle;
+	struct timespec last_frame_done;
 
 	struct wlr_buffer *saved_buffer;
 	int saved_buffer_width, saved_buffer_height;
@@ -95,8 +102,20 @@ struct sway_view {
 
 	bool destroying;
 
+	// The result of view_is_visible, which is only valid while no node has
+	// been marked dirty since it was computed and the seat is the same.
+	bool visible;
+	uint64_t visible_serial; // root->dirty_serial when computed, 0 if never
+	struct sway_seat *visible_seat;
+
 	list_t *executed_criteria; // struct criteria *
 
+	// Bumped whenever a property matched by criteria regexes changes.
+	// criteria_matches is only valid while its generation is current.
+	uint32_t prop_generation;
+	uint32_t criteria_matches_generation;
+	hash_table_t *criteria_matches; // criteria serial -> memoised result
+
 	union {
 		struct wlr_xdg_surface_v6 *wlr_xdg_surface_v6;
 		struct wlr_xdg_surface *wlr_xdg_surface;
@@ -344,6 +363,12 @@ struct sway_view *view_from_wlr_surface(struct wlr_surface *surface);
  */
 void view_update_title(struct sway_view *view, bool force);
 
+/**
+ * Invalidate memoised criteria matches after a property criteria can match on
+ * (title, app_id, class, instance, window_role or marks) has changed.
+ */
+void view_bump_prop_generation(struct sway_view *view);
+
 /**
  * Run any criteria that match the view and haven't been run on this view
  * before.
@@ -356,6 +381,11 @@ void view_execute_criteria(struct sway_view *view);
  */
 bool view_is_visible(struct sway_view *view);
 
+/**
+ * Recompute the cached visibility of the view. Returns true if it changed.
+ */
+bool view_update_visibility(struct sway_view *view);
+
 void view_set_urgent(struct sway_view *view, bool enable);
 
 bool view_is_urgent(struct sway_view *view);
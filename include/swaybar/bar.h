@@ -3,6 +3,7 @@
 #include <wayland-client.h>
 #include "config.h"
 #include "input.h"
+#include "list.h"
 #include "pool-buffer.h"
 #include "wlr-layer-shell-unstable-v1-client-protocol.h"
 #include "xdg-output-unstable-v1-client-protocol.h"
@@ -14,6 +15,7 @@ struct swaybar_tray;
 #endif
 struct swaybar_workspace;
 struct loop;
+struct loop_timer;
 
 struct swaybar {
 	char *id;
@@ -36,6 +38,7 @@ struct swaybar {
 	struct swaybar_pointer pointer;
 	struct swaybar_touch touch;
 	struct status_line *status;
+	struct loop_timer *status_timer; // while status_min_interval delays reads
 
 	struct loop *eventloop;
 
@@ -71,8 +74,14 @@ struct swaybar_output {
 	uint32_t width, height;
 	int32_t scale;
 	enum wl_output_subpixel subpixel;
-	struct pool_buffer buffers[2];
+	struct buffer_pool buffer_pool;
 	struct pool_buffer *current_buffer;
+	// The last frame and the elements it was drawn from, so that only
+	// what changed needs to be drawn and damaged
+	cairo_surface_t *canvas;
+	uint32_t canvas_background;
+	enum wl_output_subpixel canvas_subpixel;
+	list_t *elements; // struct render_element
 	bool dirty;
 	bool frame_scheduled;
 
@@ -81,6 +90,7 @@ struct swaybar_output {
 
 struct swaybar_workspace {
 	struct wl_list link; // swaybar_output::workspaces
+	int id;
 	int num;
 	char *name;
 	char *label;
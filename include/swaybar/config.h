@@ -45,6 +45,7 @@ struct swaybar_config {
 	int height;
 	int status_padding;
 	int status_edge_padding;
+	int status_min_interval;
 	struct {
 		int top;
 		int right;
@@ -0,0 +1,140 @@
+#ifndef _SWAYBAR_I3BAR_PARSER_H
+#define _SWAYBAR_I3BAR_PARSER_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The block fields swaybar uses. Any other keys are skipped.
+ */
+enum i3bar_field {
+	I3BAR_FULL_TEXT,
+	I3BAR_SHORT_TEXT,
+	I3BAR_COLOR,
+	I3BAR_MIN_WIDTH,
+	I3BAR_ALIGN,
+	I3BAR_URGENT,
+	I3BAR_NAME,
+	I3BAR_INSTANCE,
+	I3BAR_SEPARATOR,
+	I3BAR_SEPARATOR_BLOCK_WIDTH,
+	I3BAR_MARKUP,
+	I3BAR_BACKGROUND,
+	I3BAR_BORDER,
+	I3BAR_BORDER_TOP,
+	I3BAR_BORDER_BOTTOM,
+	I3BAR_BORDER_LEFT,
+	I3BAR_BORDER_RIGHT,
+	I3BAR_FIELD_COUNT,
+};
+
+enum i3bar_value_type {
+	I3BAR_VALUE_NONE, // missing, null, or an object or array
+	I3BAR_VALUE_STRING,
+	I3BAR_VALUE_NUMBER,
+	I3BAR_VALUE_BOOLEAN,
+};
+
+struct i3bar_value {
+	enum i3bar_value_type type;
+	size_t offset; // of the text in i3bar_line::strings
+};
+
+struct i3bar_parsed_block {
+	struct i3bar_value fields[I3BAR_FIELD_COUNT];
+};
+
+/**
+ * A status line, as an array of blocks whose text is stored one after the
+ * other in a single buffer. Both are reused from line to line.
+ */
+struct i3bar_line {
+	struct i3bar_parsed_block *blocks;
+	size_t len, cap;
+	char *strings;
+	size_t strings_len, strings_cap;
+};
+
+enum i3bar_parser_expect {
+	I3BAR_EXPECT_VALUE,
+	I3BAR_EXPECT_VALUE_OR_END,
+	I3BAR_EXPECT_KEY,
+	I3BAR_EXPECT_KEY_OR_END,
+	I3BAR_EXPECT_COLON,
+	I3BAR_EXPECT_COMMA_OR_END,
+	I3BAR_EXPECT_NOTHING,
+};
+
+enum i3bar_parser_token {
+	I3BAR_TOKEN_NONE,
+	I3BAR_TOKEN_STRING,
+	I3BAR_TOKEN_ESCAPE,
+	I3BAR_TOKEN_UNICODE,
+	I3BAR_TOKEN_SCALAR,
+};
+
+#define I3BAR_PARSER_MAX_DEPTH 64
+#define I3BAR_PARSER_TOKEN_MAX 64
+
+/**
+ * Incremental parser for the infinite array of status lines sent by i3bar
+ * protocol status commands. It can be fed any number of bytes at a time and
+ * fills in status lines directly, without building a json tree.
+ */
+struct i3bar_parser {
+	enum i3bar_parser_expect expect;
+	char stack[I3BAR_PARSER_MAX_DEPTH]; // '[' or '{' of each open container
+	int depth;
+
+	enum i3bar_parser_token token;
+	bool token_is_key;
+	// Key or scalar being read, or where the string being read goes
+	char token_buf[I3BAR_PARSER_TOKEN_MAX];
+	size_t token_len;
+	bool token_overflow;
+	int field; // enum i3bar_field of the value being read, -1 to skip it
+	uint32_t codepoint;
+	int codepoint_digits;
+	uint32_t high_surrogate;
+
+	struct i3bar_line lines[2]; // the one being read and the last complete
+	int building;
+	bool line_ready;
+};
+
+void i3bar_parser_init(struct i3bar_parser *parser);
+void i3bar_parser_finish(struct i3bar_parser *parser);
+
+/**
+ * Feeds bytes from the status command to the parser. Returns false if they
+ * aren't valid, in which case the parser can't be used anymore.
+ */
+bool i3bar_parser_feed(struct i3bar_parser *parser, const char *data,
+		size_t len);
+
+/**
+ * Returns the last status line completed since the previous call, or NULL if
+ * there isn't one. It's valid until the parser is fed again.
+ */
+struct i3bar_line *i3bar_parser_take_line(struct i3bar_parser *parser);
+
+/**
+ * Returns the text of the value, or NULL if the value is missing or null.
+ * Numbers and booleans give their json text.
+ */
+const char *i3bar_value_string(struct i3bar_line *line,
+		struct i3bar_value *value);
+
+/**
+ * Returns the value as an integer. Booleans are 0 or 1, and strings are
+ * parsed as a decimal number.
+ */
+int i3bar_value_int(struct i3bar_line *line, struct i3bar_value *value);
+
+/**
+ * Returns true if the value is a number written without a fraction or
+ * exponent.
+ */
+bool i3bar_value_is_int(struct i3bar_line *line, struct i3bar_value *value);
+
+#endif
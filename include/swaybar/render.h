@@ -5,4 +5,10 @@ struct swaybar_output;
 
 void render_frame(struct swaybar_output *output);
 
+/**
+ * Frees the elements and canvas kept from the last frame, so that the next
+ * frame is drawn from scratch.
+ */
+void free_render_cache(struct swaybar_output *output);
+
 #endif
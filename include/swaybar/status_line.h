@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "bar.h"
+#include "i3bar_parser.h"
 
 enum status_protocol {
 	PROTOCOL_UNDEF,
@@ -18,10 +19,12 @@ struct status_line {
 
 	pid_t pid;
 	int read_fd, write_fd;
-	FILE *read, *write;
+	FILE *write;
 
 	enum status_protocol protocol;
 	const char *text;
+	char *text_line; // the last line of the text protocol
+	size_t text_line_size;
 	struct wl_list blocks; // i3bar_block::link
 
 	int stop_signal;
@@ -32,9 +35,7 @@ struct status_line {
 	char *buffer;
 	size_t buffer_size;
 	size_t buffer_index;
-	bool started;
-	bool expecting_comma;
-	json_tokener *tokener;
+	struct i3bar_parser parser;
 };
 
 struct status_line *status_line_init(char *cmd);
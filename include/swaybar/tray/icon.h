@@ -1,6 +1,7 @@
 #ifndef _SWAYBAR_TRAY_ICON_H
 #define _SWAYBAR_TRAY_ICON_H
 
+#include "hash-table.h"
 #include "list.h"
 
 enum subdir_type {
@@ -26,6 +27,9 @@ struct icon_theme {
 
 	char *dir;
 	list_t *subdirs; // struct icon_theme_subdir *
+	// The icons in the theme's subdirs across all basedirs, by name. Only
+	// built for the first theme of each name, which is the one looked up.
+	hash_table_t *icons; // char * -> struct icon_theme_icon *
 };
 
 void init_themes(list_t **themes, list_t **basedirs);
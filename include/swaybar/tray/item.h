@@ -14,12 +14,24 @@ struct swaybar_pixmap {
 	unsigned char pixels[];
 };
 
+// Number of sizes an item's icon is kept drawn at
+#define SNI_SCALED_ICONS 4
+
+struct swaybar_scaled_icon {
+	cairo_surface_t *surface;
+	int size;
+};
+
 struct swaybar_sni {
 	// icon properties
 	struct swaybar_tray *tray;
 	cairo_surface_t *icon;
 	int min_size;
 	int max_size;
+	int target_size; // the size the icon was looked up for
+	// The icon as it is drawn for each size it was drawn at, most recently
+	// used first, since outputs may differ in scale and bar height
+	struct swaybar_scaled_icon scaled_icons[SNI_SCALED_ICONS];
 
 	// dbus properties
 	char *watcher_id;
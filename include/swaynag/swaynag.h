@@ -83,7 +83,7 @@ struct swaynag {
 	uint32_t width;
 	uint32_t height;
 	int32_t scale;
-	struct pool_buffer buffers[2];
+	struct buffer_pool buffer_pool;
 	struct pool_buffer *current_buffer;
 
 	struct swaynag_type *type;
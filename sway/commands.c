@@ -74,6 +74,7 @@ static struct cmd_handler handlers[] = {
 	{ "hide_edge_borders", cmd_hide_edge_borders },
 	{ "include", cmd_include },
 	{ "input", cmd_input },
+	{ "interactive_update_rate", cmd_interactive_update_rate },
 	{ "mode", cmd_mode },
 	{ "mouse_warping", cmd_mouse_warping },
 	{ "new_float", cmd_default_floating_border },
@@ -110,6 +111,7 @@ static struct cmd_handler command_handlers[] = {
 	{ "create_output", cmd_create_output },
 	{ "exit", cmd_exit },
 	{ "floating", cmd_floating },
+	{ "frame_throttle", cmd_frame_throttle },
 	{ "fullscreen", cmd_fullscreen },
 	{ "kill", cmd_kill },
 	{ "layout", cmd_layout },
@@ -201,6 +203,67 @@ static void set_config_node(struct sway_node *node) {
 	}
 }
 
+/**
+ * Run a command handler on each view matched by the command list's criteria,
+ * or on the given container or focus if there's no criteria.
+ *
+ * Returns false if the rest of the command should be aborted.
+ */
+static bool run_handler(struct cmd_handler *handler, int argc, char **argv,
+		struct sway_seat *seat, struct sway_container *con, list_t *views,
+		list_t *res_list) {
+	if (!config->handler_context.using_criteria) {
+		// The container or workspace which this command will run on.
+		struct sway_node *node = con ? &con->node :
+				seat_get_focus_inactive(seat, &root->node);
+		set_config_node(node);
+		struct cmd_results *res = handler->handle(argc-1, argv+1);
+		list_add(res_list, res);
+		if (res->status == CMD_INVALID) {
+			return false;
+		}
+	} else {
+		for (int i = 0; i < views->length; ++i) {
+			struct sway_view *view = views->items[i];
+			set_config_node(&view->container->node);
+			struct cmd_results *res = handler->handle(argc-1, argv+1);
+			list_add(res_list, res);
+			if (res->status == CMD_INVALID) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Strip quotes from the arguments, find the handler and replace variables in
+ * the arguments. Returns NULL if there is no handler for the command.
+ */
+static struct cmd_handler *prepare_args(int argc, char **argv) {
+	if (strcmp(argv[0], "exec") != 0 &&
+			strcmp(argv[0], "exec_always") != 0 &&
+			strcmp(argv[0], "mode") != 0) {
+		int i;
+		for (i = 1; i < argc; ++i) {
+			if (*argv[i] == '\"' || *argv[i] == '\'') {
+				strip_quotes(argv[i]);
+			}
+		}
+	}
+	struct cmd_handler *handler = find_handler(argv[0], NULL, 0);
+	if (!handler) {
+		return NULL;
+	}
+
+	// Var replacement, for all but first argument of set
+	for (int i = handler->handle == cmd_set ? 2 : 1; i < argc; ++i) {
+		argv[i] = do_var_replacement(argv[i]);
+		unescape_string(argv[i]);
+	}
+	return handler;
+}
+
 list_t *execute_command(char *_exec, struct sway_seat *seat,
 		struct sway_container *con) {
 	list_t *res_list = create_list();
@@ -226,15 +289,15 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 		config->handler_context.using_criteria = false;
 		if (*head == '[') {
 			char *error = NULL;
-			struct criteria *criteria = criteria_parse(head, &error);
+			struct criteria *criteria = criteria_parse_cached(head, &error);
 			if (!criteria) {
 				list_add(res_list, cmd_results_new(CMD_INVALID,	"%s", error));
 				free(error);
 				goto cleanup;
 			}
+			list_free(views);
 			views = criteria_get_views(criteria);
 			head += strlen(criteria->raw);
-			criteria_destroy(criteria);
 			config->handler_context.using_criteria = true;
 			// Skip leading whitespace
 			for (; isspace(*head); ++head) {}
@@ -254,17 +317,7 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 			//TODO better handling of argv
 			int argc;
 			char **argv = split_args(cmd, &argc);
-			if (strcmp(argv[0], "exec") != 0 &&
-					strcmp(argv[0], "exec_always") != 0 &&
-					strcmp(argv[0], "mode") != 0) {
-				int i;
-				for (i = 1; i < argc; ++i) {
-					if (*argv[i] == '\"' || *argv[i] == '\'') {
-						strip_quotes(argv[i]);
-					}
-				}
-			}
-			struct cmd_handler *handler = find_handler(argv[0], NULL, 0);
+			struct cmd_handler *handler = prepare_args(argc, argv);
 			if (!handler) {
 				list_add(res_list, cmd_results_new(CMD_INVALID,
 						"Unknown/invalid command '%s'", argv[0]));
@@ -272,34 +325,9 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 				goto cleanup;
 			}
 
-			// Var replacement, for all but first argument of set
-			for (int i = handler->handle == cmd_set ? 2 : 1; i < argc; ++i) {
-				argv[i] = do_var_replacement(argv[i]);
-				unescape_string(argv[i]);
-			}
-
-			if (!config->handler_context.using_criteria) {
-				// The container or workspace which this command will run on.
-				struct sway_node *node = con ? &con->node :
-						seat_get_focus_inactive(seat, &root->node);
-				set_config_node(node);
-				struct cmd_results *res = handler->handle(argc-1, argv+1);
-				list_add(res_list, res);
-				if (res->status == CMD_INVALID) {
-					free_argv(argc, argv);
-					goto cleanup;
-				}
-			} else {
-				for (int i = 0; i < views->length; ++i) {
-					struct sway_view *view = views->items[i];
-					set_config_node(&view->container->node);
-					struct cmd_results *res = handler->handle(argc-1, argv+1);
-					list_add(res_list, res);
-					if (res->status == CMD_INVALID) {
-						free_argv(argc, argv);
-						goto cleanup;
-					}
-				}
+			if (!run_handler(handler, argc, argv, seat, con, views, res_list)) {
+				free_argv(argc, argv);
+				goto cleanup;
 			}
 			free_argv(argc, argv);
 		} while(cmdlist);
@@ -310,6 +338,174 @@ cleanup:
 	return res_list;
 }
 
+struct cmd_program_command {
+	char *cmd; // for logging
+	struct cmd_handler *handler;
+	// Quotes stripped and variables replaced. Handlers don't modify argv, so
+	// it is passed to them on every execution.
+	int argc;
+	char **argv;
+};
+
+struct cmd_program_list {
+	struct criteria *criteria; // NULL to run on the focused node
+	list_t *commands; // struct cmd_program_command
+};
+
+struct cmd_program {
+	int refs; // held by the owner and by each execution in progress
+	bool compiled; // if false, the command is run with execute_command
+	uint32_t symbols_generation;
+	list_t *lists; // struct cmd_program_list
+};
+
+static void cmd_program_clear(struct cmd_program *program) {
+	for (int i = 0; i < program->lists->length; ++i) {
+		struct cmd_program_list *list = program->lists->items[i];
+		for (int j = 0; j < list->commands->length; ++j) {
+			struct cmd_program_command *command = list->commands->items[j];
+			free(command->cmd);
+			free_argv(command->argc, command->argv);
+			free(command);
+		}
+		list_free(list->commands);
+		if (list->criteria) {
+			criteria_destroy(list->criteria);
+		}
+		free(list);
+	}
+	program->lists->length = 0;
+}
+
+void cmd_program_unref(struct cmd_program *program) {
+	if (!program || --program->refs > 0) {
+		return;
+	}
+	cmd_program_clear(program);
+	list_free(program->lists);
+	free(program);
+}
+
+/**
+ * Split and parse a command string into a program following the same steps as
+ * execute_command. If part of it can't be parsed ahead of time, the program is
+ * marked as not compiled.
+ */
+static struct cmd_program *compile_command(const char *_exec) {
+	struct cmd_program *program = calloc(1, sizeof(struct cmd_program));
+	program->refs = 1;
+	program->symbols_generation = config->symbols_generation;
+	program->lists = create_list();
+
+	char *exec = strdup(_exec);
+	char *head = exec;
+	do {
+		struct cmd_program_list *list = calloc(1, sizeof(struct cmd_program_list));
+		list->commands = create_list();
+		list_add(program->lists, list);
+		if (*head == '[') {
+			char *error = NULL;
+			list->criteria = criteria_parse(head, &error);
+			if (!list->criteria) {
+				free(error);
+				goto invalid;
+			}
+			// __focused__ is resolved at parse time, so must be parsed on
+			// every execution
+			if (strstr(list->criteria->raw, "__focused__")) {
+				goto invalid;
+			}
+			head += strlen(list->criteria->raw);
+			for (; isspace(*head); ++head) {}
+		}
+		char *cmdlist = argsep(&head, ";");
+		for (; isspace(*cmdlist); ++cmdlist) {}
+		do {
+			char *cmd = argsep(&cmdlist, ",");
+			for (; isspace(*cmd); ++cmd) {}
+			if (strcmp(cmd, "") == 0) {
+				continue;
+			}
+			struct cmd_program_command *command =
+				calloc(1, sizeof(struct cmd_program_command));
+			command->cmd = strdup(cmd);
+			command->argv = split_args(cmd, &command->argc);
+			list_add(list->commands, command);
+			command->handler = prepare_args(command->argc, command->argv);
+			// Variables set by the command would change later commands
+			if (!command->handler || command->handler->handle == cmd_set) {
+				goto invalid;
+			}
+		} while (cmdlist);
+	} while (head);
+
+	free(exec);
+	program->compiled = true;
+	return program;
+
+invalid:
+	free(exec);
+	cmd_program_clear(program);
+	return program;
+}
+
+static list_t *execute_program(struct cmd_program *program,
+		struct sway_seat *seat, struct sway_container *con) {
+	list_t *res_list = create_list();
+	config->handler_context.seat = seat;
+
+	// A command could free the program's owner, eg. by replacing a binding
+	++program->refs;
+	for (int i = 0; i < program->lists->length; ++i) {
+		struct cmd_program_list *list = program->lists->items[i];
+		list_t *views = NULL;
+		config->handler_context.using_criteria = list->criteria != NULL;
+		if (list->criteria) {
+			views = criteria_get_views(list->criteria);
+		}
+		for (int j = 0; j < list->commands->length; ++j) {
+			struct cmd_program_command *command = list->commands->items[j];
+			sway_log(SWAY_INFO, "Handling command '%s'", command->cmd);
+			if (!run_handler(command->handler, command->argc, command->argv,
+						seat, con, views, res_list)) {
+				list_free(views);
+				goto cleanup;
+			}
+		}
+		list_free(views);
+	}
+cleanup:
+	cmd_program_unref(program);
+	return res_list;
+}
+
+list_t *execute_cached_command(struct cmd_program **program, char *exec,
+		struct sway_seat *seat, struct sway_container *con) {
+	// Handlers are looked up differently while the config is loading
+	if (config->reading || !config->active) {
+		return execute_command(exec, seat, con);
+	}
+	if (seat == NULL) {
+		seat = input_manager_get_default_seat();
+		if (!sway_assert(seat, "could not find a seat to run the command on")) {
+			return NULL;
+		}
+	}
+
+	if (*program &&
+			(*program)->symbols_generation != config->symbols_generation) {
+		cmd_program_unref(*program);
+		*program = NULL;
+	}
+	if (!*program) {
+		*program = compile_command(exec);
+	}
+	if (!(*program)->compiled) {
+		return execute_command(exec, seat, con);
+	}
+	return execute_program(*program, seat, con);
+}
+
 // this is like execute_command above, except:
 // 1) it ignores empty commands (empty lines)
 // 2) it does variable substitution
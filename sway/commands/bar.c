@@ -25,6 +25,7 @@ static struct cmd_handler bar_handlers[] = {
 	{ "separator_symbol", bar_cmd_separator_symbol },
 	{ "status_command", bar_cmd_status_command },
 	{ "status_edge_padding", bar_cmd_status_edge_padding },
+	{ "status_min_interval", bar_cmd_status_min_interval },
 	{ "status_padding", bar_cmd_status_padding },
 	{ "strip_workspace_name", bar_cmd_strip_workspace_name },
 	{ "strip_workspace_numbers", bar_cmd_strip_workspace_numbers },
@@ -0,0 +1,22 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sway/commands.h"
+#include "log.h"
+
+struct cmd_results *bar_cmd_status_min_interval(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "status_min_interval", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+	char *end;
+	int interval = strtol(argv[0], &end, 10);
+	if (strlen(end) || interval < 0) {
+		return cmd_results_new(CMD_INVALID,
+				"Interval must be a positive integer");
+	}
+	config->current_bar->status_min_interval = interval;
+	sway_log(SWAY_DEBUG, "Status minimum interval on bar %s: %dms",
+			config->current_bar->id,
+			config->current_bar->status_min_interval);
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -26,6 +26,7 @@ void free_sway_binding(struct sway_binding *binding) {
 	list_free_items_and_destroy(binding->keys);
 	free(binding->input);
 	free(binding->command);
+	cmd_program_unref(binding->program);
 	free(binding);
 }
 
@@ -311,6 +312,7 @@ static struct cmd_results *cmd_bindsym_or_bindcode(int argc, char **argv,
 	if (!overwritten) {
 		list_add(mode_bindings, binding);
 	}
+	sway_mode_clear_binding_tables(config->current_mode);
 
 	sway_log(SWAY_DEBUG, "%s - Bound %s to command `%s` for device '%s'",
 		bindtype, argv[0], binding->command, binding->input);
@@ -344,7 +346,8 @@ void seat_execute_command(struct sway_seat *seat, struct sway_binding *binding)
 		}
 	}
 
-	list_t *res_list = execute_command(binding->command, seat, con);
+	list_t *res_list = execute_cached_command(&binding->program,
+			binding->command, seat, con);
 	bool success = true;
 	for (int i = 0; i < res_list->length; ++i) {
 		struct cmd_results *results = res_list->items[i];
@@ -0,0 +1,32 @@
+#include <stdlib.h>
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/tree/view.h"
+
+struct cmd_results *cmd_frame_throttle(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "frame_throttle", EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+	struct sway_container *container = config->handler_context.container;
+	if (!container || !container->view) {
+		return cmd_results_new(CMD_INVALID,
+				"Only views can have a frame_throttle");
+	}
+
+	int rate;
+	if (strcasecmp(argv[0], "off") == 0) {
+		rate = -1;
+	} else if (strcasecmp(argv[0], "output") == 0) {
+		rate = 0;
+	} else {
+		char *end;
+		rate = strtol(argv[0], &end, 10);
+		if (*end || rate <= 0) {
+			return cmd_results_new(CMD_INVALID, "Expected 'frame_throttle "
+					"<rate>|output|off' where rate is in Hz");
+		}
+	}
+	container->view->frame_throttle = rate;
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
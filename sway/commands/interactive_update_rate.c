@@ -0,0 +1,28 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "log.h"
+
+struct cmd_results *cmd_interactive_update_rate(int argc, char **argv) {
+	struct cmd_results *error = NULL;
+	if ((error = checkarg(argc, "interactive_update_rate",
+					EXPECTED_EQUAL_TO, 1))) {
+		return error;
+	}
+
+	if (strcmp(argv[0], "output") == 0) {
+		config->interactive_update_rate = -1;
+	} else if (strcmp(argv[0], "unlimited") == 0) {
+		config->interactive_update_rate = 0;
+	} else {
+		char *inv;
+		int value = strtol(argv[0], &inv, 10);
+		if (*inv != '\0' || value <= 0) {
+			return cmd_results_new(CMD_INVALID, "Invalid rate specified");
+		}
+		config->interactive_update_rate = value;
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
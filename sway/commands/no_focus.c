@@ -19,7 +19,7 @@ struct cmd_results *cmd_no_focus(int argc, char **argv) {
 	}
 
 	criteria->type = CT_NO_FOCUS;
-	list_add(config->criteria, criteria);
+	criteria_add(criteria);
 
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
@@ -12,6 +12,7 @@ static struct cmd_handler output_handlers[] = {
 	{ "disable", output_cmd_disable },
 	{ "dpms", output_cmd_dpms },
 	{ "enable", output_cmd_enable },
+	{ "frame_throttle", output_cmd_frame_throttle },
 	{ "mode", output_cmd_mode },
 	{ "pos", output_cmd_position },
 	{ "position", output_cmd_position },
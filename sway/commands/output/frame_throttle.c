@@ -0,0 +1,29 @@
+#include <stdlib.h>
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+
+struct cmd_results *output_cmd_frame_throttle(int argc, char **argv) {
+	if (!config->handler_context.output_config) {
+		return cmd_results_new(CMD_FAILURE, "Missing output config");
+	}
+	if (!argc) {
+		return cmd_results_new(CMD_INVALID, "Missing frame_throttle argument.");
+	}
+
+	int rate;
+	if (strcasecmp(argv[0], "off") == 0) {
+		rate = 0;
+	} else {
+		char *end;
+		rate = strtol(argv[0], &end, 10);
+		if (*end || rate <= 0) {
+			return cmd_results_new(CMD_INVALID, "Invalid frame_throttle rate.");
+		}
+	}
+	config->handler_context.output_config->frame_throttle = rate;
+
+	config->handler_context.leftovers.argc = argc - 1;
+	config->handler_context.leftovers.argv = argv + 1;
+	return NULL;
+}
@@ -8,6 +8,7 @@
 #include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/tree/container.h"
+#include "sway/tree/root.h"
 #include "sway/tree/workspace.h"
 
 static const char expected_syntax[] =
@@ -89,8 +90,10 @@ struct cmd_results *cmd_rename(int argc, char **argv) {
 	}
 
 	sway_log(SWAY_DEBUG, "renaming workspace '%s' to '%s'", workspace->name, new_name);
+	root_unindex_workspace(workspace);
 	free(workspace->name);
 	workspace->name = new_name;
+	root_index_workspace(workspace);
 
 	output_sort_workspaces(workspace->output);
 	ipc_event_workspace(NULL, workspace, "rename");
@@ -56,5 +56,6 @@ struct cmd_results *cmd_set(int argc, char **argv) {
 		list_qsort(config->symbols, compare_set_qsort);
 	}
 	var->value = join_args(argv + 1, argc - 1);
+	++config->symbols_generation;
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
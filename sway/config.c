@@ -16,6 +16,7 @@
 #include <linux/input-event-codes.h>
 #include <wlr/types/wlr_output.h>
 #include "sway/input/input-manager.h"
+#include "sway/input/keyboard.h"
 #include "sway/input/seat.h"
 #include "sway/commands.h"
 #include "sway/config.h"
@@ -38,6 +39,7 @@ static void free_mode(struct sway_mode *mode) {
 		return;
 	}
 	free(mode->name);
+	sway_mode_clear_binding_tables(mode);
 	if (mode->keysym_bindings) {
 		for (int i = 0; i < mode->keysym_bindings->length; i++) {
 			free_sway_binding(mode->keysym_bindings->items[i]);
@@ -110,6 +112,7 @@ void free_config(struct sway_config *config) {
 		}
 		list_free(config->seat_configs);
 	}
+	criteria_index_destroy(config->criteria_index);
 	if (config->criteria) {
 		for (int i = 0; i < config->criteria->length; ++i) {
 			criteria_destroy(config->criteria->items[i]);
@@ -181,6 +184,7 @@ static void config_defaults(struct sway_config *config) {
 	if (!(config->bars = create_list())) goto cleanup;
 	if (!(config->workspace_configs = create_list())) goto cleanup;
 	if (!(config->criteria = create_list())) goto cleanup;
+	if (!(config->criteria_index = criteria_index_create())) goto cleanup;
 	if (!(config->no_focus = create_list())) goto cleanup;
 	if (!(config->input_configs = create_list())) goto cleanup;
 	if (!(config->seat_configs = create_list())) goto cleanup;
@@ -238,6 +242,7 @@ static void config_defaults(struct sway_config *config) {
 	config->title_align = ALIGN_LEFT;
 	config->tiling_drag = true;
 	config->tiling_drag_threshold = 9;
+	config->interactive_update_rate = -1;
 
 	config->smart_gaps = false;
 	config->gaps_inner = 0;
@@ -406,6 +411,8 @@ bool load_main_config(const char *file, bool is_active, bool validating) {
 				&old_config->swaynag_config_errors,
 				sizeof(struct swaynag_instance));
 
+		// Pick up changes to the user's XKB files
+		sway_keyboard_flush_keymap_cache();
 		input_manager_reset_all_inputs();
 	}
 
@@ -472,6 +479,8 @@ bool load_main_config(const char *file, bool is_active, bool validating) {
 	}
 
 	if (is_active) {
+		// Reloading reads the wallpapers again even if they are unchanged
+		reset_swaybg();
 		reset_outputs();
 
 		config->reloading = false;
@@ -43,6 +43,7 @@ struct output_config *new_output_config(const char *name) {
 	oc->x = oc->y = -1;
 	oc->scale = -1;
 	oc->transform = -1;
+	oc->frame_throttle = -1;
 	return oc;
 }
 
@@ -86,6 +87,9 @@ void merge_output_config(struct output_config *dst, struct output_config *src) {
 	if (src->dpms_state != 0) {
 		dst->dpms_state = src->dpms_state;
 	}
+	if (src->frame_throttle != -1) {
+		dst->frame_throttle = src->frame_throttle;
+	}
 }
 
 static void merge_wildcard_on_all(struct output_config *wildcard) {
@@ -225,6 +229,13 @@ static bool set_mode(struct wlr_output *output, int width, int height,
 
 static void handle_swaybg_client_destroy(struct wl_listener *listener,
 		void *data) {
+	wl_list_remove(&server.swaybg_client_destroy.link);
+	wl_list_init(&server.swaybg_client_destroy.link);
+	server.swaybg_client = NULL;
+}
+
+static void handle_output_swaybg_client_destroy(struct wl_listener *listener,
+		void *data) {
 	struct sway_output *output =
 		wl_container_of(listener, output, swaybg_client_destroy);
 	wl_list_remove(&output->swaybg_client_destroy.link);
@@ -250,7 +261,8 @@ static bool set_cloexec(int fd, bool cloexec) {
 	return true;
 }
 
-static bool spawn_swaybg(struct sway_output *output, char *const cmd[]) {
+static bool spawn_swaybg(char *const cmd[], struct wl_client **client,
+		struct wl_listener *client_destroy) {
 	int sockets[2];
 	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
 		sway_log_errno(SWAY_ERROR, "socketpair failed");
@@ -260,15 +272,13 @@ static bool spawn_swaybg(struct sway_output *output, char *const cmd[]) {
 		return false;
 	}
 
-	output->swaybg_client = wl_client_create(server.wl_display, sockets[0]);
-	if (output->swaybg_client == NULL) {
+	*client = wl_client_create(server.wl_display, sockets[0]);
+	if (*client == NULL) {
 		sway_log_errno(SWAY_ERROR, "wl_client_create failed");
 		return false;
 	}
 
-	output->swaybg_client_destroy.notify = handle_swaybg_client_destroy;
-	wl_client_add_destroy_listener(output->swaybg_client,
-		&output->swaybg_client_destroy);
+	wl_client_add_destroy_listener(*client, client_destroy);
 
 	pid_t pid = fork();
 	if (pid < 0) {
@@ -308,6 +318,126 @@ static bool spawn_swaybg(struct sway_output *output, char *const cmd[]) {
 	return true;
 }
 
+static void handle_swaybg_idle(void *data) {
+	server.swaybg_idle = NULL;
+	if (server.swaybg_client != NULL) {
+		wl_client_destroy(server.swaybg_client);
+	}
+	list_t *args = server.swaybg_args;
+	if (args->length == 0) {
+		return;
+	}
+
+	char **cmd = calloc(args->length + 2, sizeof(char *));
+	cmd[0] = config->swaybg_command;
+	memcpy(&cmd[1], args->items, args->length * sizeof(char *));
+	server.swaybg_client_destroy.notify = handle_swaybg_client_destroy;
+	spawn_swaybg(cmd, &server.swaybg_client, &server.swaybg_client_destroy);
+	free(cmd);
+}
+
+static void respawn_swaybg(void) {
+	// Applying several output configs at once spawns swaybg only once
+	if (server.swaybg_idle == NULL) {
+		server.swaybg_idle = wl_event_loop_add_idle(server.wl_event_loop,
+			handle_swaybg_idle, NULL);
+	}
+}
+
+void reset_swaybg(void) {
+	list_t *args = server.swaybg_args;
+	for (int i = 0; i < args->length; ++i) {
+		free(args->items[i]);
+	}
+	args->length = 0;
+	respawn_swaybg();
+}
+
+static bool swaybg_is_bundled(void) {
+	return config->swaybg_command &&
+		strcmp(config->swaybg_command, "swaybg") == 0;
+}
+
+static void set_swaybg_arg(list_t *args, int index, const char *value) {
+	if (strcmp(args->items[index], value) != 0) {
+		free(args->items[index]);
+		args->items[index] = strdup(value);
+		respawn_swaybg();
+	}
+}
+
+/**
+ * Gives the output's background to the bundled swaybg, which is only
+ * respawned when the background changes. The background is kept when the
+ * output goes away, so that swaybg draws it again as soon as the output is
+ * back, without being respawned.
+ */
+static void set_swaybg_background(struct sway_output *output,
+		struct output_config *oc) {
+	const char *name = output->wlr_output->name;
+	list_t *args = server.swaybg_args;
+	int index = 0;
+	while (index < args->length && strcmp(args->items[index], name) != 0) {
+		index += 4;
+	}
+
+	if (!oc || !oc->background) {
+		if (index < args->length) {
+			for (int i = 0; i < 4; ++i) {
+				free(args->items[index]);
+				list_del(args, index);
+			}
+			respawn_swaybg();
+		}
+		return;
+	}
+
+	sway_log(SWAY_DEBUG, "Setting background for output %s to %s",
+		name, oc->background);
+	if (index == args->length) {
+		list_add(args, strdup(name));
+		list_add(args, strdup(""));
+		list_add(args, strdup(""));
+		list_add(args, strdup(""));
+	}
+	// An empty fallback means there is none
+	set_swaybg_arg(args, index + 1, oc->background);
+	set_swaybg_arg(args, index + 2, oc->background_option);
+	set_swaybg_arg(args, index + 3,
+		oc->background_fallback ? oc->background_fallback : "");
+}
+
+static bool output_set_background(struct sway_output *output,
+		struct output_config *oc) {
+	if (output->swaybg_client != NULL) {
+		wl_client_destroy(output->swaybg_client);
+	}
+	if (swaybg_is_bundled()) {
+		set_swaybg_background(output, oc);
+		return true;
+	}
+
+	// Custom commands keep getting one output at a time
+	if (oc && oc->background && config->swaybg_command) {
+		sway_log(SWAY_DEBUG, "Setting background for output %s to %s",
+			output->wlr_output->name, oc->background);
+
+		char *const cmd[] = {
+			config->swaybg_command,
+			output->wlr_output->name,
+			oc->background,
+			oc->background_option,
+			oc->background_fallback ? oc->background_fallback : NULL,
+			NULL,
+		};
+		output->swaybg_client_destroy.notify =
+			handle_output_swaybg_client_destroy;
+		return spawn_swaybg(cmd, &output->swaybg_client,
+			&output->swaybg_client_destroy);
+	}
+	return true;
+}
+
 bool apply_output_config(struct output_config *oc, struct sway_output *output) {
 	if (output == root->noop_output) {
 		return false;
@@ -367,6 +497,8 @@ bool apply_output_config(struct output_config *oc, struct sway_output *output) {
 		sway_log(SWAY_DEBUG, "Set %s transform to %d", oc->name, oc->transform);
 		wlr_output_set_transform(wlr_output, oc->transform);
 	}
+	output->frame_throttle = oc && oc->frame_throttle > 0 ?
+		oc->frame_throttle : 0;
 
 	// Find position for it
 	if (oc && (oc->x != -1 || oc->y != -1)) {
@@ -384,24 +516,8 @@ bool apply_output_config(struct output_config *oc, struct sway_output *output) {
 	wlr_output_transformed_resolution(wlr_output,
 		&output->width, &output->height);
 
-	if (output->swaybg_client != NULL) {
-		wl_client_destroy(output->swaybg_client);
-	}
-	if (oc && oc->background && config->swaybg_command) {
-		sway_log(SWAY_DEBUG, "Setting background for output %s to %s",
-			wlr_output->name, oc->background);
-
-		char *const cmd[] = {
-			config->swaybg_command,
-			wlr_output->name,
-			oc->background,
-			oc->background_option,
-			oc->background_fallback ? oc->background_fallback : NULL,
-			NULL,
-		};
-		if (!spawn_swaybg(output, cmd)) {
-			return false;
-		}
+	if (!output_set_background(output, oc)) {
+		return false;
 	}
 
 	if (oc && oc->dpms_state == DPMS_OFF) {
@@ -426,6 +542,7 @@ static void default_output_config(struct output_config *oc,
 	oc->scale = 1;
 	oc->transform = WL_OUTPUT_TRANSFORM_NORMAL;
 	oc->dpms_state = DPMS_ON;
+	oc->frame_throttle = 0;
 }
 
 static struct output_config *get_output_config(char *identifier,
@@ -4,12 +4,14 @@
 #include <stdbool.h>
 #include <strings.h>
 #include <pcre.h>
+#include "sway/commands.h"
 #include "sway/criteria.h"
 #include "sway/tree/container.h"
 #include "sway/config.h"
 #include "sway/tree/root.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
+#include "hash-table.h"
 #include "stringop.h"
 #include "list.h"
 #include "log.h"
@@ -34,24 +36,36 @@ bool criteria_is_empty(struct criteria *criteria) {
 		&& !criteria->workspace;
 }
 
+static void pattern_destroy(struct pattern *pattern) {
+	if (!pattern) {
+		return;
+	}
+	pcre_free_study(pattern->extra);
+	pcre_free(pattern->regex);
+	free(pattern->literal);
+	free(pattern);
+}
+
 void criteria_destroy(struct criteria *criteria) {
-	pcre_free(criteria->title);
-	pcre_free(criteria->shell);
-	pcre_free(criteria->app_id);
+	pattern_destroy(criteria->title);
+	pattern_destroy(criteria->shell);
+	pattern_destroy(criteria->app_id);
 #if HAVE_XWAYLAND
-	pcre_free(criteria->class);
-	pcre_free(criteria->instance);
-	pcre_free(criteria->window_role);
+	pattern_destroy(criteria->class);
+	pattern_destroy(criteria->instance);
+	pattern_destroy(criteria->window_role);
 #endif
-	pcre_free(criteria->con_mark);
-	free(criteria->workspace);
+	pattern_destroy(criteria->con_mark);
+	pattern_destroy(criteria->workspace);
+	cmd_program_unref(criteria->program);
 	free(criteria->cmdlist);
 	free(criteria->raw);
 	free(criteria);
 }
 
-static int regex_cmp(const char *item, const pcre *regex) {
-	return pcre_exec(regex, NULL, item, strlen(item), 0, 0, NULL, 0);
+static int regex_cmp(const char *item, const struct pattern *pattern) {
+	return pcre_exec(pattern->regex, pattern->extra, item, strlen(item),
+			0, 0, NULL, 0);
 }
 
 #if HAVE_XWAYLAND
@@ -71,32 +85,7 @@ static bool view_has_window_type(struct sway_view *view, enum atom_name name) {
 }
 #endif
 
-static int cmp_urgent(const void *_a, const void *_b) {
-	struct sway_view *a = *(void **)_a;
-	struct sway_view *b = *(void **)_b;
-
-	if (a->urgent.tv_sec < b->urgent.tv_sec) {
-		return -1;
-	} else if (a->urgent.tv_sec > b->urgent.tv_sec) {
-		return 1;
-	}
-	if (a->urgent.tv_nsec < b->urgent.tv_nsec) {
-		return -1;
-	} else if (a->urgent.tv_nsec > b->urgent.tv_nsec) {
-		return 1;
-	}
-	return 0;
-}
-
-static void find_urgent_iterator(struct sway_container *con, void *data) {
-	if (!con->view || !view_is_urgent(con->view)) {
-		return;
-	}
-	list_t *urgent_views = data;
-	list_add(urgent_views, con->view);
-}
-
-static bool criteria_matches_view(struct criteria *criteria,
+static bool criteria_matches_view_props(struct criteria *criteria,
 		struct sway_view *view) {
 	if (criteria->title) {
 		const char *title = view_get_title(view);
@@ -133,20 +122,7 @@ static bool criteria_matches_view(struct criteria *criteria,
 		}
 	}
 
-	if (criteria->con_id) { // Internal ID
-		if (!view->container || view->container->node.id != criteria->con_id) {
-			return false;
-		}
-	}
-
 #if HAVE_XWAYLAND
-	if (criteria->id) { // X11 window ID
-		uint32_t x11_window_id = view_get_x11_window_id(view);
-		if (!x11_window_id || x11_window_id != criteria->id) {
-			return false;
-		}
-	}
-
 	if (criteria->class) {
 		const char *class = view_get_class(view);
 		if (!class || regex_cmp(class, criteria->class) != 0) {
@@ -167,6 +143,72 @@ static bool criteria_matches_view(struct criteria *criteria,
 			return false;
 		}
 	}
+#endif
+
+	return true;
+}
+
+static bool criteria_has_props(struct criteria *criteria) {
+	return criteria->title
+		|| criteria->shell
+		|| criteria->app_id
+		|| criteria->con_mark
+#if HAVE_XWAYLAND
+		|| criteria->class
+		|| criteria->instance
+		|| criteria->window_role
+#endif
+		;
+}
+
+// Upper bound on memoised results per view, as every criteria parsed for an
+// IPC command gets a new serial
+#define CRITERIA_MATCHES_MAX 1024
+
+#define MEMO_MATCH ((void *)1)
+#define MEMO_NO_MATCH ((void *)2)
+
+/**
+ * Match the regex properties of the criteria against the view, reusing the
+ * result from a previous call if none of the view's properties have changed
+ * since.
+ */
+static bool criteria_matches_view_props_memo(struct criteria *criteria,
+		struct sway_view *view) {
+	if (!criteria_has_props(criteria)) {
+		return true;
+	}
+	hash_table_t *memo = view->criteria_matches;
+	if (view->criteria_matches_generation != view->prop_generation ||
+			memo->length >= CRITERIA_MATCHES_MAX) {
+		hash_table_clear(memo);
+		view->criteria_matches_generation = view->prop_generation;
+	}
+	const void *key = (void *)criteria->serial;
+	void *result = hash_table_get(memo, key);
+	if (result) {
+		return result == MEMO_MATCH;
+	}
+	bool matches = criteria_matches_view_props(criteria, view);
+	hash_table_set(memo, key, matches ? MEMO_MATCH : MEMO_NO_MATCH);
+	return matches;
+}
+
+static bool criteria_matches_view(struct criteria *criteria,
+		struct sway_view *view) {
+	if (criteria->con_id) { // Internal ID
+		if (!view->container || view->container->node.id != criteria->con_id) {
+			return false;
+		}
+	}
+
+#if HAVE_XWAYLAND
+	if (criteria->id) { // X11 window ID
+		uint32_t x11_window_id = view_get_x11_window_id(view);
+		if (!x11_window_id || x11_window_id != criteria->id) {
+			return false;
+		}
+	}
 
 	if (criteria->window_type != ATOM_LAST) {
 		if (!view_has_window_type(view, criteria->window_type)) {
@@ -187,21 +229,21 @@ static bool criteria_matches_view(struct criteria *criteria,
 		}
 	}
 
+	if (!criteria_matches_view_props_memo(criteria, view)) {
+		return false;
+	}
+
 	if (criteria->urgent) {
 		if (!view_is_urgent(view)) {
 			return false;
 		}
-		list_t *urgent_views = create_list();
-		root_for_each_container(find_urgent_iterator, urgent_views);
-		list_stable_sort(urgent_views, cmp_urgent);
-		struct sway_view *target;
+		struct wl_list *target;
 		if (criteria->urgent == 'o') { // oldest
-			target = urgent_views->items[0];
+			target = root->urgent_views.next;
 		} else { // latest
-			target = urgent_views->items[urgent_views->length - 1];
+			target = root->urgent_views.prev;
 		}
-		list_free(urgent_views);
-		if (view != target) {
+		if (&view->urgent_link != target) {
 			return false;
 		}
 	}
@@ -216,15 +258,145 @@ static bool criteria_matches_view(struct criteria *criteria,
 	return true;
 }
 
+struct criteria_index {
+	hash_table_t *app_id; // literal -> list_t of criteria
+	hash_table_t *shell;
+#if HAVE_XWAYLAND
+	hash_table_t *class;
+	list_t *window_type[ATOM_LAST];
+#endif
+	list_t *unindexed;
+};
+
+struct criteria_index *criteria_index_create(void) {
+	struct criteria_index *index = calloc(1, sizeof(struct criteria_index));
+	if (!index) {
+		return NULL;
+	}
+	index->app_id = create_hash_table(hash_string, equal_string);
+	index->shell = create_hash_table(hash_string, equal_string);
+#if HAVE_XWAYLAND
+	index->class = create_hash_table(hash_string, equal_string);
+	for (int i = 0; i < ATOM_LAST; ++i) {
+		index->window_type[i] = create_list();
+	}
+#endif
+	index->unindexed = create_list();
+	return index;
+}
+
+static void free_bucket(const void *key, void *value, void *data) {
+	list_free(value);
+}
+
+static void index_table_destroy(hash_table_t *table) {
+	hash_table_for_each(table, free_bucket, NULL);
+	hash_table_free(table);
+}
+
+void criteria_index_destroy(struct criteria_index *index) {
+	if (!index) {
+		return;
+	}
+	index_table_destroy(index->app_id);
+	index_table_destroy(index->shell);
+#if HAVE_XWAYLAND
+	index_table_destroy(index->class);
+	for (int i = 0; i < ATOM_LAST; ++i) {
+		list_free(index->window_type[i]);
+	}
+#endif
+	list_free(index->unindexed);
+	free(index);
+}
+
+static void index_table_add(hash_table_t *table, const char *key,
+		struct criteria *criteria) {
+	list_t *bucket = hash_table_get(table, key);
+	if (!bucket) {
+		bucket = create_list();
+		hash_table_set(table, key, bucket);
+	}
+	list_add(bucket, criteria);
+}
+
+/**
+ * Every criteria is filed under exactly one key: the most selective property
+ * that only matches a literal value, or the unindexed list if there is none.
+ */
+void criteria_add(struct criteria *criteria) {
+	struct criteria_index *index = config->criteria_index;
+	criteria->order = config->criteria->length;
+	list_add(config->criteria, criteria);
+
+	if (criteria->app_id && criteria->app_id->literal) {
+		index_table_add(index->app_id, criteria->app_id->literal, criteria);
+#if HAVE_XWAYLAND
+	} else if (criteria->class && criteria->class->literal) {
+		index_table_add(index->class, criteria->class->literal, criteria);
+	} else if (criteria->window_type != ATOM_LAST) {
+		list_add(index->window_type[criteria->window_type], criteria);
+#endif
+	} else if (criteria->shell && criteria->shell->literal) {
+		index_table_add(index->shell, criteria->shell->literal, criteria);
+	} else {
+		list_add(index->unindexed, criteria);
+	}
+}
+
+static void index_table_find(hash_table_t *table, const char *value,
+		list_t *candidates) {
+	if (!value || !table->length) {
+		return;
+	}
+	list_t *bucket = hash_table_get(table, value);
+	if (bucket) {
+		list_cat(candidates, bucket);
+	}
+	// `$` also matches before a final newline
+	size_t len = strlen(value);
+	if (len && value[len - 1] == '\n') {
+		char *stripped = strndup(value, len - 1);
+		bucket = hash_table_get(table, stripped);
+		if (bucket) {
+			list_cat(candidates, bucket);
+		}
+		free(stripped);
+	}
+}
+
+static int cmp_order(const void *_a, const void *_b) {
+	struct criteria *a = *(void **)_a;
+	struct criteria *b = *(void **)_b;
+	return a->order - b->order;
+}
+
 list_t *criteria_for_view(struct sway_view *view, enum criteria_type types) {
-	list_t *criterias = config->criteria;
+	struct criteria_index *index = config->criteria_index;
+	list_t *candidates = create_list();
+	list_cat(candidates, index->unindexed);
+	index_table_find(index->app_id, view_get_app_id(view), candidates);
+	index_table_find(index->shell, view_get_shell(view), candidates);
+#if HAVE_XWAYLAND
+	index_table_find(index->class, view_get_class(view), candidates);
+	for (int i = 0; i < ATOM_LAST; ++i) {
+		if (index->window_type[i]->length &&
+				view_has_window_type(view, i)) {
+			list_cat(candidates, index->window_type[i]);
+		}
+	}
+#endif
+	// Criteria must be applied in the order they appear in the config
+	list_qsort(candidates, cmp_order);
+
 	list_t *matches = create_list();
-	for (int i = 0; i < criterias->length; ++i) {
-		struct criteria *criteria = criterias->items[i];
+	for (int i = 0; i < candidates->length; ++i) {
+		struct criteria *criteria = candidates->items[i];
 		if ((criteria->type & types) && criteria_matches_view(criteria, view)) {
 			list_add(matches, criteria);
 		}
 	}
+	list_free(candidates);
 	return matches;
 }
 
@@ -245,6 +417,27 @@ static void criteria_get_views_iterator(struct sway_container *container,
 
 list_t *criteria_get_views(struct criteria *criteria) {
 	list_t *matches = create_list();
+
+	// A con_id or literal con_mark identifies at most one container
+	struct sway_container *con = NULL;
+	if (criteria->con_id) {
+		struct sway_node *node = node_from_id(criteria->con_id);
+		if (!node || node->type != N_CONTAINER) {
+			return matches;
+		}
+		con = node->sway_container;
+	} else if (criteria->con_mark && criteria->con_mark->literal) {
+		if (!(con = container_find_mark(criteria->con_mark->literal))) {
+			return matches;
+		}
+	}
+	if (con) {
+		if (con->view && criteria_matches_view(criteria, con->view)) {
+			list_add(matches, con->view);
+		}
+		return matches;
+	}
+
 	struct match_data data = {
 		.criteria = criteria,
 		.matches = matches,
@@ -257,14 +450,44 @@ list_t *criteria_get_views(struct criteria *criteria) {
 // as an argument in several places.
 char *error = NULL;
 
+/**
+ * If the regex can only match one exact string (ie. it is of the form
+ * ^literal$ without any other metacharacters), return that string.
+ */
+static char *regex_literal(const char *value) {
+	size_t len = strlen(value);
+	if (len < 2 || value[0] != '^' || value[len - 1] != '$' ||
+			(len > 2 && value[len - 2] == '\\')) {
+		return NULL;
+	}
+	char *literal = calloc(len - 1, 1);
+	char *writehead = literal;
+	for (const char *c = value + 1; c < value + len - 1; ++c) {
+		if (*c == '\\') {
+			// Only escaped punctuation is a literal character
+			++c;
+			if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+					(*c >= '0' && *c <= '9')) {
+				free(literal);
+				return NULL;
+			}
+		} else if (strchr(".^$|()[]{}?*+", *c)) {
+			free(literal);
+			return NULL;
+		}
+		*writehead++ = *c;
+	}
+	return literal;
+}
+
 // Returns error string on failure or NULL otherwise.
-static bool generate_regex(pcre **regex, char *value) {
+static bool generate_regex(struct pattern **pattern, char *value) {
 	const char *reg_err;
 	int offset;
 
-	*regex = pcre_compile(value, PCRE_UTF8 | PCRE_UCP, &reg_err, &offset, NULL);
+	pcre *regex = pcre_compile(value, PCRE_UTF8 | PCRE_UCP, &reg_err, &offset, NULL);
 
-	if (!*regex) {
+	if (!regex) {
 		const char *fmt = "Regex compilation for '%s' failed: %s";
 		int len = strlen(fmt) + strlen(value) + strlen(reg_err) - 3;
 		error = malloc(len);
@@ -272,6 +495,16 @@ static bool generate_regex(pcre **regex, char *value) {
 		return false;
 	}
 
+	// Criteria are matched far more often than they are compiled
+	pcre_extra *extra = pcre_study(regex, PCRE_STUDY_JIT_COMPILE, &reg_err);
+	if (reg_err) {
+		sway_log(SWAY_DEBUG, "Regex study for '%s' failed: %s", value, reg_err);
+	}
+
+	*pattern = calloc(1, sizeof(struct pattern));
+	(*pattern)->regex = regex;
+	(*pattern)->extra = extra;
+	(*pattern)->literal = regex_literal(value);
 	return true;
 }
 
@@ -575,7 +808,9 @@ struct criteria *criteria_parse(char *raw, char **error_arg) {
 	}
 	++head;
 
+	static uintptr_t next_serial = 1;
 	struct criteria *criteria = calloc(1, sizeof(struct criteria));
+	criteria->serial = next_serial++;
 #if HAVE_XWAYLAND
 	criteria->window_type = ATOM_LAST; // default value
 #endif
@@ -658,3 +893,109 @@ cleanup:
 	criteria_destroy(criteria);
 	return NULL;
 }
+
+// Number of parsed criteria kept by criteria_parse_cached
+#define CRITERIA_CACHE_CAPACITY 64
+
+struct criteria_cache_entry {
+	struct criteria *criteria;
+	struct wl_list link; // criteria_cache::entries
+};
+
+static struct {
+	hash_table_t *table; // raw criteria -> struct criteria_cache_entry
+	struct wl_list entries; // most recently used first
+	// Criteria which can't be cached, destroyed on the next call
+	struct criteria *uncached;
+	size_t hits, misses;
+} criteria_cache;
+
+/**
+ * Find the length of the criteria at the start of raw, up to the first closing
+ * bracket which isn't quoted. This doesn't need to agree with criteria_parse:
+ * a cached criteria's raw string is only found if raw starts with it, in which
+ * case parsing raw would give the same criteria.
+ */
+static size_t criteria_length(const char *raw) {
+	bool in_quotes = false;
+	for (const char *c = raw; *c; ++c) {
+		if (*c == '"' && (c == raw || c[-1] != '\\')) {
+			in_quotes = !in_quotes;
+		} else if (*c == ']' && !in_quotes) {
+			return c - raw + 1;
+		}
+	}
+	return 0;
+}
+
+static void criteria_cache_evict(void) {
+	struct criteria_cache_entry *entry =
+		wl_container_of(criteria_cache.entries.prev, entry, link);
+	hash_table_del(criteria_cache.table, entry->criteria->raw);
+	wl_list_remove(&entry->link);
+	criteria_destroy(entry->criteria);
+	free(entry);
+}
+
+struct criteria *criteria_parse_cached(char *raw, char **error_arg) {
+	if (!criteria_cache.table) {
+		criteria_cache.table = create_hash_table(hash_string, equal_string);
+		wl_list_init(&criteria_cache.entries);
+	}
+	if (criteria_cache.uncached) {
+		criteria_destroy(criteria_cache.uncached);
+		criteria_cache.uncached = NULL;
+	}
+
+	size_t len = criteria_length(raw);
+	if (len) {
+		char *key = strndup(raw, len);
+		struct criteria_cache_entry *entry =
+			hash_table_get(criteria_cache.table, key);
+		free(key);
+		if (entry) {
+			++criteria_cache.hits;
+			wl_list_remove(&entry->link);
+			wl_list_insert(&criteria_cache.entries, &entry->link);
+			*error_arg = NULL;
+			return entry->criteria;
+		}
+	}
+
+	++criteria_cache.misses;
+	struct criteria *criteria = criteria_parse(raw, error_arg);
+	if (!criteria) {
+		return NULL;
+	}
+	// __focused__ is resolved when parsing
+	if (strstr(criteria->raw, "__focused__")) {
+		criteria_cache.uncached = criteria;
+		return criteria;
+	}
+
+	struct criteria_cache_entry *entry =
+		hash_table_get(criteria_cache.table, criteria->raw);
+	if (entry) {
+		// criteria_length disagreed with criteria_parse
+		criteria_destroy(criteria);
+		wl_list_remove(&entry->link);
+		wl_list_insert(&criteria_cache.entries, &entry->link);
+		return entry->criteria;
+	}
+
+	if (criteria_cache.table->length >= CRITERIA_CACHE_CAPACITY) {
+		criteria_cache_evict();
+	}
+	entry = calloc(1, sizeof(struct criteria_cache_entry));
+	entry->criteria = criteria;
+	wl_list_insert(&criteria_cache.entries, &entry->link);
+	hash_table_set(criteria_cache.table, criteria->raw, entry);
+	return criteria;
+}
+
+void criteria_cache_get_stats(struct criteria_cache_stats *stats) {
+	stats->hits = criteria_cache.hits;
+	stats->misses = criteria_cache.misses;
+	stats->size = criteria_cache.table ? criteria_cache.table->length : 0;
+	stats->capacity = CRITERIA_CACHE_CAPACITY;
+}
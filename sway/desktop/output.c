@@ -65,6 +65,9 @@ static void rotate_child_position(double *sx, double *sy, double sw, double sh,
 struct surface_iterator_data {
 	sway_surface_iterator_func_t user_iterator;
 	void *user_data;
+	// Skips the surfaces of views for which it returns false, if set
+	bool (*view_filter)(struct sway_output *output, struct sway_view *view,
+		void *user_data);
 
 	struct sway_output *output;
 	double ox, oy;
@@ -234,12 +237,18 @@ static void for_each_surface_container_iterator(struct sway_container *con,
 	}
 
 	struct surface_iterator_data *data = _data;
+	if (data->view_filter &&
+			!data->view_filter(data->output, con->view, data->user_data)) {
+		return;
+	}
 	output_view_for_each_surface(data->output, con->view,
 		data->user_iterator, data->user_data);
 }
 
-static void output_for_each_surface(struct sway_output *output,
-		sway_surface_iterator_func_t iterator, void *user_data) {
+static void output_for_each_surface_filtered(struct sway_output *output,
+		sway_surface_iterator_func_t iterator, void *user_data,
+		bool (*view_filter)(struct sway_output *output,
+			struct sway_view *view, void *user_data)) {
 	if (output_has_opaque_overlay_layer_surface(output)) {
 		goto overlay;
 	}
@@ -247,6 +256,7 @@ static void output_for_each_surface(struct sway_output *output,
 	struct surface_iterator_data data = {
 		.user_iterator = iterator,
 		.user_data = user_data,
+		.view_filter = view_filter,
 		.output = output,
 	};
 
@@ -308,6 +318,11 @@ overlay:
 		iterator, user_data);
 }
 
+static void output_for_each_surface(struct sway_output *output,
+		sway_surface_iterator_func_t iterator, void *user_data) {
+	output_for_each_surface_filtered(output, iterator, user_data, NULL);
+}
+
 static int scale_length(int length, int offset, float scale) {
 	return round((offset + length) * scale) - round(offset * scale);
 }
@@ -360,15 +375,94 @@ bool output_has_opaque_overlay_layer_surface(struct sway_output *output) {
 	return false;
 }
 
+struct send_frame_done_data {
+	struct timespec *when;
+	int throttle_delay; // msec until a throttled view is due, -1 if none
+};
+
 static void send_frame_done_iterator(struct sway_output *output,
 		struct wlr_surface *surface, struct wlr_box *box, float rotation,
-		void *data) {
-	struct timespec *when = data;
-	wlr_surface_send_frame_done(surface, when);
+		void *_data) {
+	struct send_frame_done_data *data = _data;
+	wlr_surface_send_frame_done(surface, data->when);
+}
+
+/**
+ * Returns true if a seat focuses the view, or a container holding it.
+ */
+static bool view_has_seat_focus(struct sway_view *view) {
+	struct sway_seat *seat;
+	wl_list_for_each(seat, &server.input->seats, link) {
+		struct sway_node *focus = seat_get_focus(seat);
+		if (!focus || focus->type != N_CONTAINER) {
+			continue;
+		}
+		struct sway_container *con = focus->sway_container;
+		if (con == view->container ||
+				container_has_ancestor(view->container, con)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns the frame rate the view is throttled to on this output, or 0 if it
+ * isn't throttled. Only views without focus are throttled; views on hidden
+ * tabs don't get frame events at all.
+ */
+static int view_frame_throttle(struct sway_output *output,
+		struct sway_view *view) {
+	if (view->frame_throttle < 0 || view_has_seat_focus(view)) {
+		return 0;
+	}
+	return view->frame_throttle > 0 ?
+		view->frame_throttle : output->frame_throttle;
+}
+
+static bool send_frame_done_view_filter(struct sway_output *output,
+		struct sway_view *view, void *_data) {
+	struct send_frame_done_data *data = _data;
+	int rate = view_frame_throttle(output, view);
+	if (rate <= 0) {
+		return true;
+	}
+	int64_t elapsed =
+		(data->when->tv_sec - view->last_frame_done.tv_sec) * 1000 +
+		(data->when->tv_nsec - view->last_frame_done.tv_nsec) / 1000000;
+	int interval = 1000 / rate;
+	if (elapsed >= 0 && elapsed < interval) {
+		int delay = interval - elapsed;
+		if (data->throttle_delay < 0 || delay < data->throttle_delay) {
+			data->throttle_delay = delay;
+		}
+		return false;
+	}
+	view->last_frame_done = *data->when;
+	return true;
+}
+
+static int handle_frame_throttle_timer(void *data) {
+	struct sway_output *output = data;
+	if (output->enabled && output->wlr_output->enabled) {
+		wlr_output_schedule_frame(output->wlr_output);
+	}
+	return 0;
 }
 
 static void send_frame_done(struct sway_output *output, struct timespec *when) {
-	output_for_each_surface(output, send_frame_done_iterator, when);
+	struct send_frame_done_data data = {
+		.when = when,
+		.throttle_delay = -1,
+	};
+	output_for_each_surface_filtered(output, send_frame_done_iterator, &data,
+		send_frame_done_view_filter);
+	// A throttled client waits for its frame event before drawing again, so
+	// nothing else might cause the output to produce the frame it's due.
+	if (data.throttle_delay >= 0) {
+		wl_event_source_timer_update(output->frame_throttle_timer,
+			data.throttle_delay > 0 ? data.throttle_delay : 1);
+	}
 }
 
 static void damage_handle_frame(struct wl_listener *listener, void *data) {
@@ -403,6 +497,7 @@ void output_damage_whole(struct sway_output *output) {
 	// and the transaction to evacuate it has't completed yet.
 	if (output && output->wlr_output && output->damage) {
 		wlr_output_damage_add_whole(output->damage);
+		input_latency_damage(output);
 	}
 }
 
@@ -442,6 +537,7 @@ static void damage_surface_iterator(struct sway_output *output,
 	}
 
 	wlr_output_schedule_frame(output->wlr_output);
+	input_latency_damage(output);
 }
 
 void output_damage_surface(struct sway_output *output, double ox, double oy,
@@ -467,6 +563,7 @@ void output_damage_box(struct sway_output *output, struct wlr_box *_box) {
 	box.y -= output->ly;
 	scale_box(&box, output->wlr_output->scale);
 	wlr_output_damage_add_box(output->damage, &box);
+	input_latency_damage(output);
 }
 
 static void damage_child_views_iterator(struct sway_container *con,
@@ -491,6 +588,7 @@ void output_damage_whole_container(struct sway_output *output,
 	};
 	scale_box(&box, output->wlr_output->scale);
 	wlr_output_damage_add_box(output->damage, &box);
+	input_latency_damage(output);
 	// Damage subsurfaces as well, which may extend outside the box
 	if (con->view) {
 		damage_child_views_iterator(con, output);
@@ -526,6 +624,7 @@ static void handle_destroy(struct wl_listener *listener, void *data) {
 	wl_list_remove(&output->damage_destroy.link);
 	wl_list_remove(&output->damage_frame.link);
 	wl_list_remove(&output->swaybg_client_destroy.link);
+	wl_event_source_remove(output->frame_throttle_timer);
 
 	transaction_commit_dirty();
 }
@@ -595,6 +694,8 @@ static void handle_present(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	input_latency_present(output, output_event->when);
+
 	struct wlr_presentation_event event = {
 		.output = output->wlr_output,
 		.tv_sec = (uint64_t)output_event->when->tv_sec,
@@ -633,6 +734,8 @@ void handle_new_output(struct wl_listener *listener, void *data) {
 	wl_signal_add(&output->damage->events.destroy, &output->damage_destroy);
 	output->damage_destroy.notify = damage_handle_destroy;
 	wl_list_init(&output->swaybg_client_destroy.link);
+	output->frame_throttle_timer = wl_event_loop_add_timer(
+		server->wl_event_loop, handle_frame_throttle_timer, output);
 
 	struct output_config *oc = find_output_config(output);
 	if (!oc || oc->enabled) {
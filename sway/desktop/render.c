@@ -1100,4 +1100,5 @@ renderer_end:
 		return;
 	}
 	output->last_frame = *when;
+	input_latency_frame(output);
 }
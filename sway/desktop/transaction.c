@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,6 +26,8 @@ struct sway_transaction {
 	size_t num_waiting;
 	size_t num_configures;
 	struct timespec commit_time;
+	// Input events which caused the transaction, shown once it's applied
+	struct input_latency_marks input_latency;
 };
 
 struct sway_transaction_instruction {
@@ -274,6 +277,62 @@ static void apply_container_state(struct sway_container *container,
 	}
 }
 
+static bool lists_equal(list_t *a, list_t *b) {
+	if (!a || !b) {
+		return a == b;
+	}
+	if (a->length != b->length) {
+		return false;
+	}
+	for (int i = 0; i < a->length; ++i) {
+		if (a->items[i] != b->items[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Return true if going from one workspace state to another may change what is
+ * under the cursor.
+ */
+static bool workspace_state_moved(struct sway_workspace_state *a,
+		struct sway_workspace_state *b) {
+	return a->fullscreen != b->fullscreen || a->x != b->x || a->y != b->y ||
+		a->width != b->width || a->height != b->height ||
+		a->layout != b->layout || a->output != b->output ||
+		a->focused_inactive_child != b->focused_inactive_child ||
+		!lists_equal(a->floating, b->floating) ||
+		!lists_equal(a->tiling, b->tiling);
+}
+
+/**
+ * Return true if going from one container state to another may change what is
+ * under the cursor. Borders and focus only matter through the content box.
+ */
+static bool container_state_moved(struct sway_container_state *a,
+		struct sway_container_state *b) {
+	return a->layout != b->layout || a->x != b->x || a->y != b->y ||
+		a->width != b->width || a->height != b->height ||
+		a->fullscreen_mode != b->fullscreen_mode ||
+		a->workspace != b->workspace || a->parent != b->parent ||
+		a->focused_inactive_child != b->focused_inactive_child ||
+		a->content_x != b->content_x || a->content_y != b->content_y ||
+		a->content_width != b->content_width ||
+		a->content_height != b->content_height ||
+		!lists_equal(a->children, b->children);
+}
+
+static void add_touched_box(pixman_region32_t *touched,
+		double x, double y, double width, double height) {
+	if (width <= 0 || height <= 0) {
+		return;
+	}
+	// Pad by 1px, because the coordinates are doubles
+	pixman_region32_union_rect(touched, touched, floor(x) - 1, floor(y) - 1,
+			ceil(width) + 2, ceil(height) + 2);
+}
+
 /**
  * Apply a transaction to the "current" state of the tree.
  */
@@ -289,6 +348,12 @@ static void transaction_apply(struct sway_transaction *transaction) {
 				"(%.1f frames if 60Hz)", transaction, ms, ms / (1000.0f / 60));
 	}
 
+	input_latency_resume(&transaction->input_latency);
+
+	// The area in which what's under the cursor may have changed
+	pixman_region32_t touched;
+	pixman_region32_init(&touched);
+
 	// Apply the instruction state to the node's current state
 	for (int i = 0; i < transaction->instructions->length; ++i) {
 		struct sway_transaction_instruction *instruction =
@@ -298,23 +363,72 @@ static void transaction_apply(struct sway_transaction *transaction) {
 		switch (node->type) {
 		case N_ROOT:
 			break;
-		case N_OUTPUT:
-			apply_output_state(node->sway_output, &instruction->output_state);
+		case N_OUTPUT: {
+			struct sway_output *output = node->sway_output;
+			struct sway_output_state *output_state =
+				&instruction->output_state;
+			if (node->destroying || output->current.active_workspace !=
+					output_state->active_workspace ||
+					!lists_equal(output->current.workspaces,
+						output_state->workspaces)) {
+				add_touched_box(&touched, output->lx, output->ly,
+						output->width, output->height);
+			}
+			apply_output_state(output, output_state);
 			break;
-		case N_WORKSPACE:
-			apply_workspace_state(node->sway_workspace,
-					&instruction->workspace_state);
+		}
+		case N_WORKSPACE: {
+			struct sway_workspace *ws = node->sway_workspace;
+			struct sway_workspace_state *ws_state =
+				&instruction->workspace_state;
+			if (node->destroying ||
+					workspace_state_moved(&ws->current, ws_state)) {
+				add_touched_box(&touched, ws->current.x, ws->current.y,
+						ws->current.width, ws->current.height);
+				add_touched_box(&touched, ws_state->x, ws_state->y,
+						ws_state->width, ws_state->height);
+			}
+			apply_workspace_state(ws, ws_state);
 			break;
-		case N_CONTAINER:
-			apply_container_state(node->sway_container,
-					&instruction->container_state);
+		}
+		case N_CONTAINER: {
+			struct sway_container *con = node->sway_container;
+			struct sway_container_state old = con->current;
+			double surface_x = con->surface_x, surface_y = con->surface_y;
+			double surface_width = con->surface_width;
+			double surface_height = con->surface_height;
+			bool moved = node->destroying ||
+				container_state_moved(&old, &instruction->container_state);
+			apply_container_state(con, &instruction->container_state);
+			if (con->view && !node->destroying) {
+				view_update_visibility(con->view);
+			}
+			// The view's surface may have been re-centered
+			moved = moved || surface_x != con->surface_x ||
+				surface_y != con->surface_y ||
+				surface_width != con->surface_width ||
+				surface_height != con->surface_height;
+			if (moved) {
+				add_touched_box(&touched, old.x, old.y,
+						old.width, old.height);
+				add_touched_box(&touched, con->current.x, con->current.y,
+						con->current.width, con->current.height);
+			}
 			break;
 		}
+		}
 
 		node->instruction = NULL;
 	}
 
-	cursor_rebase_all();
+	for (int i = 0; i < root->outputs->length; ++i) {
+		output_update_hit_grid(root->outputs->items[i]);
+	}
+
+	cursor_rebase_region(&touched);
+	pixman_region32_fini(&touched);
+
+	input_latency_end();
 }
 
 static void transaction_commit(struct sway_transaction *transaction);
@@ -360,6 +474,7 @@ static void transaction_progress_queue(void) {
 		struct sway_transaction *a = server.transactions->items[0];
 		struct sway_transaction *b = server.transactions->items[1];
 		if (transaction_same_nodes(a, b)) {
+			input_latency_merge(&b->input_latency, &a->input_latency);
 			list_del(server.transactions, 0);
 			transaction_destroy(a);
 		} else {
@@ -532,6 +647,7 @@ void transaction_commit_dirty(void) {
 		node->dirty = false;
 	}
 	server.dirty_nodes->length = 0;
+	input_latency_carry(&transaction->input_latency);
 
 	list_add(server.transactions, transaction);
 
@@ -513,6 +513,7 @@ static void handle_set_title(struct wl_listener *listener, void *data) {
 		wl_container_of(listener, xwayland_view, set_title);
 	struct sway_view *view = &xwayland_view->view;
 	struct wlr_xwayland_surface *xsurface = view->wlr_xwayland_surface;
+	view_bump_prop_generation(view);
 	if (!xsurface->mapped) {
 		return;
 	}
@@ -525,6 +526,7 @@ static void handle_set_class(struct wl_listener *listener, void *data) {
 		wl_container_of(listener, xwayland_view, set_class);
 	struct sway_view *view = &xwayland_view->view;
 	struct wlr_xwayland_surface *xsurface = view->wlr_xwayland_surface;
+	view_bump_prop_generation(view);
 	if (!xsurface->mapped) {
 		return;
 	}
@@ -536,6 +538,7 @@ static void handle_set_role(struct wl_listener *listener, void *data) {
 		wl_container_of(listener, xwayland_view, set_role);
 	struct sway_view *view = &xwayland_view->view;
 	struct wlr_xwayland_surface *xsurface = view->wlr_xwayland_surface;
+	view_bump_prop_generation(view);
 	if (!xsurface->mapped) {
 		return;
 	}
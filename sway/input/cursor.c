@@ -174,6 +174,21 @@ void cursor_rebase_all(void) {
 	}
 }
 
+void cursor_rebase_region(pixman_region32_t *region) {
+	if (!root->outputs->length) {
+		return;
+	}
+
+	struct sway_seat *seat;
+	wl_list_for_each(seat, &server.input->seats, link) {
+		struct wlr_cursor *cursor = seat->cursor->cursor;
+		if (pixman_region32_contains_point(region,
+					floor(cursor->x), floor(cursor->y), NULL)) {
+			cursor_rebase(seat->cursor);
+		}
+	}
+}
+
 static int hide_notify(void *data) {
 	struct sway_cursor *cursor = data;
 	wlr_cursor_set_image(cursor->cursor, NULL, 0, 0, 0, 0, 0, 0);
@@ -260,9 +275,11 @@ static void handle_cursor_motion_relative(
 	struct sway_cursor *cursor = wl_container_of(listener, cursor, motion);
 	struct wlr_event_pointer_motion *e = data;
 
+	input_latency_begin(e->device->data, e->time_msec);
 	cursor_motion(cursor, e->time_msec, e->device, e->delta_x, e->delta_y,
 			e->unaccel_dx, e->unaccel_dy);
 	transaction_commit_dirty();
+	input_latency_end();
 }
 
 static void handle_cursor_motion_absolute(
@@ -278,8 +295,10 @@ static void handle_cursor_motion_absolute(
 	double dx = lx - cursor->cursor->x;
 	double dy = ly - cursor->cursor->y;
 
+	input_latency_begin(event->device->data, event->time_msec);
 	cursor_motion(cursor, event->time_msec, event->device, dx, dy, dx, dy);
 	transaction_commit_dirty();
+	input_latency_end();
 }
 
 void dispatch_cursor_button(struct sway_cursor *cursor,
@@ -307,9 +326,11 @@ static void handle_cursor_button(struct wl_listener *listener, void *data) {
 		}
 	}
 
+	input_latency_begin(event->device->data, event->time_msec);
 	dispatch_cursor_button(cursor, event->device,
 			event->time_msec, event->button, event->state);
 	transaction_commit_dirty();
+	input_latency_end();
 }
 
 void dispatch_cursor_axis(struct sway_cursor *cursor,
@@ -463,9 +484,11 @@ static void handle_tool_axis(struct wl_listener *listener, void *data) {
 	double dx = lx - cursor->cursor->x;
 	double dy = ly - cursor->cursor->y;
 
+	input_latency_begin(input_device, event->time_msec);
 	cursor_motion(cursor, event->time_msec, event->device, dx, dy, dx, dy);
 	wlr_seat_pointer_notify_frame(cursor->seat->wlr_seat);
 	transaction_commit_dirty();
+	input_latency_end();
 }
 
 static void handle_tool_tip(struct wl_listener *listener, void *data) {
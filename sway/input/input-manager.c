@@ -441,6 +441,7 @@ static void handle_device_destroy(struct wl_listener *listener, void *data) {
 		seat_remove_device(seat, input_device);
 	}
 
+	input_latency_device_destroy(input_device);
 	wl_list_remove(&input_device->link);
 	wl_list_remove(&input_device->device_destroy.link);
 	free(input_device->identifier);
@@ -613,6 +614,13 @@ void input_manager_set_focus(struct sway_node *node) {
 	}
 }
 
+void input_manager_node_children_changed(struct sway_node *node) {
+	struct sway_seat *seat;
+	wl_list_for_each(seat, &server.input->seats, link) {
+		seat_node_children_changed(seat, node);
+	}
+}
+
 void input_manager_apply_input_config(struct input_config *input_config) {
 	struct sway_input_device *input_device = NULL;
 	bool wildcard = strcmp(input_config->identifier, "*") == 0;
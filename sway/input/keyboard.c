@@ -1,5 +1,7 @@
 #include <assert.h>
 #include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <wlr/backend/multi.h>
 #include <wlr/backend/session.h>
@@ -137,47 +139,166 @@ static void update_shortcut_state(struct sway_shortcut_state *state,
 	}
 }
 
+/**
+ * The part of a binding which has to match exactly for it to be active. The
+ * locked flag and the input device are checked separately, since a locked
+ * binding or one for all devices also applies in other cases.
+ */
+struct binding_key {
+	uint32_t modifiers;
+	bool release;
+	size_t nkeys;
+	uint32_t keys[SWAY_KEYBOARD_PRESSED_KEYS_CAP];
+};
+
+/**
+ * A binding in a lookup table bucket, along with its position in the mode's
+ * binding list so that candidates from several buckets can be considered in
+ * the order the list would have given them.
+ */
+struct binding_ref {
+	struct sway_binding *binding;
+	int index;
+};
+
+static uint32_t hash_binding_key(const void *_key) {
+	const struct binding_key *key = _key;
+	uint32_t hash = 2166136261u;
+	uint32_t words[] = { key->modifiers, key->release, key->nkeys };
+	for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+		hash = (hash ^ words[i]) * 16777619u;
+	}
+	for (size_t i = 0; i < key->nkeys; ++i) {
+		hash = (hash ^ key->keys[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static bool equal_binding_key(const void *_a, const void *_b) {
+	const struct binding_key *a = _a, *b = _b;
+	return a->modifiers == b->modifiers && a->release == b->release &&
+		a->nkeys == b->nkeys &&
+		memcmp(a->keys, b->keys, a->nkeys * sizeof(uint32_t)) == 0;
+}
+
+/**
+ * Build a table mapping each binding key to the list of bindings with that
+ * key, in the order of the binding list.
+ */
+static hash_table_t *create_binding_table(list_t *bindings) {
+	hash_table_t *table = create_hash_table(hash_binding_key,
+			equal_binding_key);
+	for (int i = 0; i < bindings->length; ++i) {
+		struct sway_binding *binding = bindings->items[i];
+		if (binding->keys->length > SWAY_KEYBOARD_PRESSED_KEYS_CAP) {
+			// Can never be pressed
+			continue;
+		}
+		struct binding_key *key = calloc(1, sizeof(struct binding_key));
+		key->modifiers = binding->modifiers;
+		key->release = binding->flags & BINDING_RELEASE;
+		key->nkeys = binding->keys->length;
+		for (size_t j = 0; j < key->nkeys; ++j) {
+			key->keys[j] = *(uint32_t *)binding->keys->items[j];
+		}
+
+		list_t *bucket = hash_table_get(table, key);
+		if (bucket) {
+			free(key);
+		} else {
+			bucket = create_list();
+			hash_table_set(table, key, bucket);
+		}
+		struct binding_ref *ref = malloc(sizeof(struct binding_ref));
+		ref->binding = binding;
+		ref->index = i;
+		list_add(bucket, ref);
+	}
+	return table;
+}
+
+static void free_binding_table_entry(const void *key, void *bucket,
+		void *data) {
+	free((void *)key);
+	list_free_items_and_destroy(bucket);
+}
+
+static void destroy_binding_table(hash_table_t *table) {
+	if (!table) {
+		return;
+	}
+	hash_table_for_each(table, free_binding_table_entry, NULL);
+	hash_table_free(table);
+}
+
+void sway_mode_clear_binding_tables(struct sway_mode *mode) {
+	destroy_binding_table(mode->keysym_table);
+	destroy_binding_table(mode->keycode_table);
+	mode->keysym_table = NULL;
+	mode->keycode_table = NULL;
+}
+
+static hash_table_t *get_keysym_table(struct sway_mode *mode) {
+	if (!mode->keysym_table) {
+		mode->keysym_table = create_binding_table(mode->keysym_bindings);
+	}
+	return mode->keysym_table;
+}
+
+static hash_table_t *get_keycode_table(struct sway_mode *mode) {
+	if (!mode->keycode_table) {
+		mode->keycode_table = create_binding_table(mode->keycode_bindings);
+	}
+	return mode->keycode_table;
+}
+
 /**
  * If one exists, finds a binding which matches the shortcut model state,
  * current modifiers, release state, and locked state.
+ *
+ * A binding matches if its keys are exactly the pressed keys or, failing
+ * that, if it is a single-key binding for the newly-pressed key. Both are
+ * looked up in the table, so only bindings for these keys are considered.
  */
 static void get_active_binding(const struct sway_shortcut_state *state,
-		list_t *bindings, struct sway_binding **current_binding,
+		hash_table_t *table, struct sway_binding **current_binding,
 		uint32_t modifiers, bool release, bool locked, const char *input) {
-	for (int i = 0; i < bindings->length; ++i) {
-		struct sway_binding *binding = bindings->items[i];
-		bool binding_locked = binding->flags & BINDING_LOCKED;
-		bool binding_release = binding->flags & BINDING_RELEASE;
+	struct binding_key key = {
+		.modifiers = modifiers,
+		.release = release,
+		.nkeys = state->npressed,
+	};
+	memcpy(key.keys, state->pressed_keys, state->npressed * sizeof(uint32_t));
+	list_t *exact = hash_table_get(table, &key);
+
+	list_t *single = NULL;
+	if (state->npressed != 1) {
+		key.nkeys = 1;
+		key.keys[0] = state->current_key;
+		single = hash_table_get(table, &key);
+	}
+
+	int exact_len = exact ? exact->length : 0;
+	int single_len = single ? single->length : 0;
+	int i = 0, j = 0;
+	while (i < exact_len || j < single_len) {
+		struct binding_ref *ref;
+		if (j >= single_len || (i < exact_len &&
+				((struct binding_ref *)exact->items[i])->index <
+				((struct binding_ref *)single->items[j])->index)) {
+			ref = exact->items[i++];
+		} else {
+			ref = single->items[j++];
+		}
+		struct sway_binding *binding = ref->binding;
 
-		if (modifiers ^ binding->modifiers ||
-				release != binding_release ||
-				locked > binding_locked ||
+		bool binding_locked = binding->flags & BINDING_LOCKED;
+		if (locked > binding_locked ||
 				(strcmp(binding->input, input) != 0 &&
 				 strcmp(binding->input, "*") != 0)) {
 			continue;
 		}
 
-		bool match = false;
-		if (state->npressed == (size_t)binding->keys->length) {
-			match = true;
-			for (size_t j = 0; j < state->npressed; j++) {
-				uint32_t key = *(uint32_t *)binding->keys->items[j];
-				if (key != state->pressed_keys[j]) {
-					match = false;
-					break;
-				}
-			}
-		} else if (binding->keys->length == 1) {
-			/*
-			 * If no multiple-key binding has matched, try looking for
-			 * single-key bindings that match the newly-pressed key.
-			 */
-			match = state->current_key == *(uint32_t *)binding->keys->items[0];
-		}
-		if (!match) {
-			continue;
-		}
-
 		if (*current_binding && *current_binding != binding &&
 				strcmp((*current_binding)->input, binding->input) == 0) {
 			sway_log(SWAY_DEBUG, "encountered duplicate bindings %d and %d",
@@ -288,6 +409,7 @@ static void handle_keyboard_key(struct wl_listener *listener, void *data) {
 	wlr_idle_notify_activity(server.idle, wlr_seat);
 	struct wlr_event_keyboard_key *event = data;
 	bool input_inhibited = seat->exclusive_client != NULL;
+	input_latency_begin(keyboard->seat_device->input_device, event->time_msec);
 
 	// Identify new keycode, raw keysym(s), and translated keysym(s)
 	xkb_keycode_t keycode = event->keycode + 8;
@@ -320,17 +442,19 @@ static void handle_keyboard_key(struct wl_listener *listener, void *data) {
 	}
 
 	bool handled = false;
+	hash_table_t *keycode_table = get_keycode_table(config->current_mode);
+	hash_table_t *keysym_table = get_keysym_table(config->current_mode);
 
 	// Identify active release binding
 	struct sway_binding *binding_released = NULL;
 	get_active_binding(&keyboard->state_keycodes,
-			config->current_mode->keycode_bindings, &binding_released,
+			keycode_table, &binding_released,
 			code_modifiers, true, input_inhibited, device_identifier);
 	get_active_binding(&keyboard->state_keysyms_raw,
-			config->current_mode->keysym_bindings, &binding_released,
+			keysym_table, &binding_released,
 			raw_modifiers, true, input_inhibited, device_identifier);
 	get_active_binding(&keyboard->state_keysyms_translated,
-			config->current_mode->keysym_bindings, &binding_released,
+			keysym_table, &binding_released,
 			translated_modifiers, true, input_inhibited, device_identifier);
 
 	// Execute stored release binding once no longer active
@@ -350,13 +474,13 @@ static void handle_keyboard_key(struct wl_listener *listener, void *data) {
 	struct sway_binding *binding = NULL;
 	if (event->state == WLR_KEY_PRESSED) {
 		get_active_binding(&keyboard->state_keycodes,
-				config->current_mode->keycode_bindings, &binding,
+				keycode_table, &binding,
 				code_modifiers, false, input_inhibited, device_identifier);
 		get_active_binding(&keyboard->state_keysyms_raw,
-				config->current_mode->keysym_bindings, &binding,
+				keysym_table, &binding,
 				raw_modifiers, false, input_inhibited, device_identifier);
 		get_active_binding(&keyboard->state_keysyms_translated,
-				config->current_mode->keysym_bindings, &binding,
+				keysym_table, &binding,
 				translated_modifiers, false, input_inhibited,
 				device_identifier);
 	}
@@ -397,6 +521,7 @@ static void handle_keyboard_key(struct wl_listener *listener, void *data) {
 	}
 
 	transaction_commit_dirty();
+	input_latency_end();
 
 	free(device_identifier);
 }
@@ -449,6 +574,160 @@ static void handle_keyboard_modifiers(struct wl_listener *listener,
 	determine_bar_visibility(modifiers);
 }
 
+// Number of compiled keymaps kept around while no keyboard uses them
+#define KEYMAP_CACHE_UNUSED_MAX 8
+
+struct keymap_cache_entry {
+	struct xkb_rule_names names;
+	struct xkb_keymap *keymap;
+	int refs; // number of keyboards using the keymap
+	bool stale; // compiled before the cache was flushed, never reused
+	struct wl_list link; // keymap_cache::entries
+};
+
+/**
+ * Compiling a keymap takes several milliseconds, so keyboards with the same
+ * RMLVO names share one, and a few unused ones are kept for hotplugging.
+ */
+static struct {
+	struct xkb_context *context;
+	struct wl_list entries; // most recently used first
+	int unused;
+} keymap_cache;
+
+static bool names_equal(const char *a, const char *b) {
+	if (!a || !b) {
+		return a == b;
+	}
+	return strcmp(a, b) == 0;
+}
+
+static bool rule_names_equal(const struct xkb_rule_names *a,
+		const struct xkb_rule_names *b) {
+	return names_equal(a->rules, b->rules) &&
+		names_equal(a->model, b->model) &&
+		names_equal(a->layout, b->layout) &&
+		names_equal(a->variant, b->variant) &&
+		names_equal(a->options, b->options);
+}
+
+static char *names_dup(const char *name) {
+	return name ? strdup(name) : NULL;
+}
+
+static void keymap_cache_entry_destroy(struct keymap_cache_entry *entry) {
+	wl_list_remove(&entry->link);
+	xkb_keymap_unref(entry->keymap);
+	free((char *)entry->names.rules);
+	free((char *)entry->names.model);
+	free((char *)entry->names.layout);
+	free((char *)entry->names.variant);
+	free((char *)entry->names.options);
+	free(entry);
+}
+
+/**
+ * Get the keymap for the given names, compiling it if it isn't cached. The
+ * keymap must be given back with keymap_cache_release.
+ */
+static struct xkb_keymap *keymap_cache_acquire(
+		const struct xkb_rule_names *names) {
+	if (!keymap_cache.entries.next) {
+		wl_list_init(&keymap_cache.entries);
+	}
+	if (!keymap_cache.context) {
+		keymap_cache.context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+		if (!sway_assert(keymap_cache.context, "cannot create XKB context")) {
+			return NULL;
+		}
+	}
+
+	struct keymap_cache_entry *entry;
+	wl_list_for_each(entry, &keymap_cache.entries, link) {
+		if (!entry->stale && rule_names_equal(&entry->names, names)) {
+			if (entry->refs++ == 0) {
+				--keymap_cache.unused;
+			}
+			wl_list_remove(&entry->link);
+			wl_list_insert(&keymap_cache.entries, &entry->link);
+			return entry->keymap;
+		}
+	}
+
+	struct xkb_keymap *keymap = xkb_keymap_new_from_names(
+			keymap_cache.context, names, XKB_KEYMAP_COMPILE_NO_FLAGS);
+	if (!keymap) {
+		return NULL;
+	}
+	entry = calloc(1, sizeof(struct keymap_cache_entry));
+	if (!sway_assert(entry, "could not allocate keymap cache entry")) {
+		xkb_keymap_unref(keymap);
+		return NULL;
+	}
+	entry->names.rules = names_dup(names->rules);
+	entry->names.model = names_dup(names->model);
+	entry->names.layout = names_dup(names->layout);
+	entry->names.variant = names_dup(names->variant);
+	entry->names.options = names_dup(names->options);
+	entry->keymap = keymap;
+	entry->refs = 1;
+	wl_list_insert(&keymap_cache.entries, &entry->link);
+	return keymap;
+}
+
+static void keymap_cache_release(struct xkb_keymap *keymap) {
+	if (!keymap) {
+		return;
+	}
+	struct keymap_cache_entry *entry;
+	wl_list_for_each(entry, &keymap_cache.entries, link) {
+		if (entry->keymap == keymap) {
+			break;
+		}
+	}
+	if (!sway_assert(&entry->link != &keymap_cache.entries,
+				"keymap is not in the cache")) {
+		return;
+	}
+	if (--entry->refs > 0) {
+		return;
+	}
+	if (entry->stale) {
+		keymap_cache_entry_destroy(entry);
+		return;
+	}
+	++keymap_cache.unused;
+
+	// Evict the least recently used unused keymaps
+	struct keymap_cache_entry *tmp;
+	wl_list_for_each_reverse_safe(entry, tmp, &keymap_cache.entries, link) {
+		if (keymap_cache.unused <= KEYMAP_CACHE_UNUSED_MAX) {
+			break;
+		}
+		if (entry->refs == 0) {
+			keymap_cache_entry_destroy(entry);
+			--keymap_cache.unused;
+		}
+	}
+}
+
+void sway_keyboard_flush_keymap_cache(void) {
+	if (keymap_cache.entries.next) {
+		struct keymap_cache_entry *entry, *tmp;
+		wl_list_for_each_safe(entry, tmp, &keymap_cache.entries, link) {
+			if (entry->refs == 0) {
+				keymap_cache_entry_destroy(entry);
+			} else {
+				entry->stale = true;
+			}
+		}
+	}
+	keymap_cache.unused = 0;
+	// Keymaps keep their own reference to the context
+	xkb_context_unref(keymap_cache.context);
+	keymap_cache.context = NULL;
+}
+
 struct sway_keyboard *sway_keyboard_create(struct sway_seat *seat,
 		struct sway_seat_device *device) {
 	struct sway_keyboard *keyboard =
@@ -506,21 +785,13 @@ void sway_keyboard_configure(struct sway_keyboard *keyboard) {
 		rules.variant = getenv("XKB_DEFAULT_VARIANT");
 	}
 
-	struct xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-	if (!sway_assert(context, "cannot create XKB context")) {
-		return;
-	}
-
-	struct xkb_keymap *keymap =
-		xkb_keymap_new_from_names(context, &rules, XKB_KEYMAP_COMPILE_NO_FLAGS);
-
+	struct xkb_keymap *keymap = keymap_cache_acquire(&rules);
 	if (!keymap) {
 		sway_log(SWAY_DEBUG, "cannot configure keyboard: keymap does not exist");
-		xkb_context_unref(context);
 		return;
 	}
 
-	xkb_keymap_unref(keyboard->keymap);
+	keymap_cache_release(keyboard->keymap);
 	keyboard->keymap = keymap;
 	wlr_keyboard_set_keymap(wlr_device->keyboard, keyboard->keymap);
 
@@ -560,7 +831,6 @@ void sway_keyboard_configure(struct sway_keyboard *keyboard) {
 	wlr_keyboard_set_repeat_info(wlr_device->keyboard, repeat_rate,
 			repeat_delay);
 
-	xkb_context_unref(context);
 	struct wlr_seat *seat = keyboard->seat_device->sway_seat->wlr_seat;
 	wlr_seat_set_keyboard(seat, wlr_device);
 
@@ -578,9 +848,7 @@ void sway_keyboard_destroy(struct sway_keyboard *keyboard) {
 	if (!keyboard) {
 		return;
 	}
-	if (keyboard->keymap) {
-		xkb_keymap_unref(keyboard->keymap);
-	}
+	keymap_cache_release(keyboard->keymap);
 	wl_list_remove(&keyboard->keyboard_key.link);
 	wl_list_remove(&keyboard->keyboard_modifiers.link);
 	sway_keyboard_disarm_key_repeat(keyboard);
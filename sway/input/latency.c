@@ -0,0 +1,141 @@
+#include <stddef.h>
+#include "sway/input/input-manager.h"
+#include "sway/input/latency.h"
+#include "sway/output.h"
+
+// Number of recent input events which can wait for their damage to be shown
+#define INPUT_LATENCY_MARKS 256
+
+struct input_latency_mark {
+	struct sway_input_device *device; // NULL once counted
+	uint32_t time_msec;
+	uint64_t serial;
+};
+
+/**
+ * Input events are numbered with serials and kept in a ring buffer, indexed
+ * by serial, until they are presented or overwritten. Whatever carries them
+ * only holds their serials.
+ */
+static struct {
+	struct input_latency_mark marks[INPUT_LATENCY_MARKS];
+	uint64_t serial; // serial of the latest input event
+	struct input_latency_marks current; // the events being handled
+	int depth; // nesting of input_latency_begin and input_latency_resume
+} input_latency;
+
+static void marks_add(struct input_latency_marks *marks, uint64_t serial) {
+	for (size_t i = 0; i < marks->len; ++i) {
+		if (marks->serials[i] == serial) {
+			return;
+		}
+	}
+	if (marks->len < INPUT_LATENCY_CARRIED) {
+		marks->serials[marks->len++] = serial;
+	}
+}
+
+void input_latency_merge(struct input_latency_marks *dest,
+		const struct input_latency_marks *src) {
+	for (size_t i = 0; i < src->len; ++i) {
+		marks_add(dest, src->serials[i]);
+	}
+}
+
+void input_latency_begin(struct sway_input_device *device, uint32_t time_msec) {
+	++input_latency.depth;
+	if (!device) {
+		return;
+	}
+	uint64_t serial = ++input_latency.serial;
+	struct input_latency_mark *mark =
+		&input_latency.marks[serial % INPUT_LATENCY_MARKS];
+	mark->device = device;
+	mark->time_msec = time_msec;
+	mark->serial = serial;
+	marks_add(&input_latency.current, serial);
+}
+
+void input_latency_resume(const struct input_latency_marks *marks) {
+	++input_latency.depth;
+	input_latency_merge(&input_latency.current, marks);
+}
+
+void input_latency_end(void) {
+	if (input_latency.depth > 0 && --input_latency.depth == 0) {
+		input_latency.current.len = 0;
+	}
+}
+
+void input_latency_carry(struct input_latency_marks *marks) {
+	if (input_latency.depth > 0) {
+		input_latency_merge(marks, &input_latency.current);
+	}
+}
+
+void input_latency_damage(struct sway_output *output) {
+	input_latency_carry(&output->input_latency_damage);
+}
+
+void input_latency_frame(struct sway_output *output) {
+	input_latency_merge(&output->input_latency_frame,
+			&output->input_latency_damage);
+	output->input_latency_damage.len = 0;
+}
+
+static void record_latency(struct sway_input_latency *latency, uint32_t msec) {
+	++latency->histogram[msec];
+	++latency->count;
+	if (msec > latency->max) {
+		latency->max = msec;
+	}
+}
+
+void input_latency_present(struct sway_output *output,
+		const struct timespec *when) {
+	struct input_latency_marks *frame = &output->input_latency_frame;
+	uint32_t when_msec = when->tv_sec * 1000 + when->tv_nsec / 1000000;
+	for (size_t i = 0; i < frame->len; ++i) {
+		uint64_t serial = frame->serials[i];
+		struct input_latency_mark *mark =
+			&input_latency.marks[serial % INPUT_LATENCY_MARKS];
+		// Skip events which were overwritten or shown on another output
+		if (mark->serial != serial || !mark->device) {
+			continue;
+		}
+		// Events from backends with another clock end up out of range
+		uint32_t msec = when_msec - mark->time_msec;
+		if (msec < INPUT_LATENCY_MAX_MSEC) {
+			record_latency(&mark->device->latency, msec);
+		}
+		mark->device = NULL;
+	}
+	frame->len = 0;
+}
+
+void input_latency_device_destroy(struct sway_input_device *device) {
+	for (size_t i = 0; i < INPUT_LATENCY_MARKS; ++i) {
+		if (input_latency.marks[i].device == device) {
+			input_latency.marks[i].device = NULL;
+		}
+	}
+}
+
+uint32_t input_latency_percentile(const struct sway_input_latency *latency,
+		double fraction) {
+	if (!latency->count) {
+		return 0;
+	}
+	uint64_t rank = fraction * latency->count;
+	if (rank >= latency->count) {
+		rank = latency->count - 1;
+	}
+	uint64_t seen = 0;
+	for (uint32_t msec = 0; msec < INPUT_LATENCY_MAX_MSEC; ++msec) {
+		seen += latency->histogram[msec];
+		if (seen > rank) {
+			return msec;
+		}
+	}
+	return latency->max;
+}
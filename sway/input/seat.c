@@ -12,6 +12,7 @@
 #include "log.h"
 #include "sway/debug.h"
 #include "sway/desktop.h"
+#include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/keyboard.h"
@@ -43,6 +44,7 @@ void seat_destroy(struct sway_seat *seat) {
 		seat_device_destroy(seat_device);
 	}
 	sway_cursor_destroy(seat->cursor);
+	wl_event_source_remove(seat->seatop_motion_timer);
 	wl_list_remove(&seat->new_node.link);
 	wl_list_remove(&seat->request_start_drag.link);
 	wl_list_remove(&seat->start_drag.link);
@@ -51,13 +53,29 @@ void seat_destroy(struct sway_seat *seat) {
 	wl_list_remove(&seat->link);
 	wlr_seat_destroy(seat->wlr_seat);
 	free(seat->prev_workspace_name);
+	hash_table_free(seat->focus_nodes);
 	free(seat);
 }
 
+static struct sway_seat_node *seat_node_lookup(struct sway_seat *seat,
+		struct sway_node *node) {
+	return hash_table_get(seat->focus_nodes, (void *)(uintptr_t)node->id);
+}
+
+static void seat_node_update_ancestors(struct sway_seat *seat,
+		struct sway_node *node);
+
 static void seat_node_destroy(struct sway_seat_node *seat_node) {
+	struct sway_seat *seat = seat_node->seat;
+	struct sway_node *parent = node_get_parent(seat_node->node);
+	hash_table_del(seat->focus_nodes, (void *)(uintptr_t)seat_node->node->id);
 	wl_list_remove(&seat_node->destroy.link);
 	wl_list_remove(&seat_node->link);
 	free(seat_node);
+	// The parent may still point at it
+	if (parent) {
+		seat_node_update_ancestors(seat, parent);
+	}
 }
 
 /**
@@ -114,6 +132,197 @@ static void seat_send_focus(struct sway_node *node, struct sway_seat *seat) {
 	}
 }
 
+static void summarize_children(struct sway_seat *seat,
+		struct sway_seat_node *seat_node, list_t *children) {
+	for (int i = 0; i < children->length; ++i) {
+		struct sway_container *con = children->items[i];
+		struct sway_seat_node *child = seat_node_lookup(seat, &con->node);
+		if (!child) {
+			continue;
+		}
+		if (!seat_node->active_child ||
+				child->focus_order > seat_node->active_child->focus_order) {
+			seat_node->active_child = child;
+		}
+		if (!seat_node->focus_child ||
+				child->subtree_order > seat_node->focus_child->subtree_order) {
+			seat_node->focus_child = child;
+		}
+		if (child->view_order != INT64_MIN && (!seat_node->focus_view_child ||
+					child->view_order > seat_node->focus_view_child->view_order)) {
+			seat_node->focus_view_child = child;
+		}
+	}
+}
+
+/**
+ * Compute the summary of the node's children from scratch.
+ */
+static void seat_node_summarize(struct sway_seat *seat,
+		struct sway_seat_node *seat_node) {
+	struct sway_node *node = seat_node->node;
+	seat_node->active_child = NULL;
+	seat_node->focus_child = NULL;
+	seat_node->focus_view_child = NULL;
+	seat_node->subtree_order = seat_node->focus_order;
+	seat_node->view_order =
+		node_is_view(node) ? seat_node->focus_order : INT64_MIN;
+	if (node->type == N_WORKSPACE) {
+		summarize_children(seat, seat_node, node->sway_workspace->tiling);
+		summarize_children(seat, seat_node, node->sway_workspace->floating);
+	} else if (node->type == N_CONTAINER && node->sway_container->children) {
+		summarize_children(seat, seat_node, node->sway_container->children);
+	}
+	struct sway_seat_node *child = seat_node->focus_child;
+	if (child && child->subtree_order > seat_node->subtree_order) {
+		seat_node->subtree_order = child->subtree_order;
+	}
+	child = seat_node->focus_view_child;
+	if (child && child->view_order > seat_node->view_order) {
+		seat_node->view_order = child->view_order;
+	}
+}
+
+/**
+ * Summarize the node again, and its ancestors for as long as that changes
+ * what they see of it.
+ */
+static void seat_node_update_ancestors(struct sway_seat *seat,
+		struct sway_node *node) {
+	for (; node; node = node_get_parent(node)) {
+		struct sway_seat_node *seat_node = seat_node_lookup(seat, node);
+		if (!seat_node) {
+			return;
+		}
+		int64_t subtree_order = seat_node->subtree_order;
+		int64_t view_order = seat_node->view_order;
+		seat_node_summarize(seat, seat_node);
+		if (seat_node->subtree_order == subtree_order &&
+				seat_node->view_order == view_order) {
+			return;
+		}
+	}
+}
+
+void seat_node_children_changed(struct sway_seat *seat,
+		struct sway_node *node) {
+	seat_node_update_ancestors(seat, node);
+}
+
+/**
+ * Move the node to the top of the focus stack. As it's now the most recently
+ * focused node of every subtree it's in, its ancestors are updated without
+ * looking at their other children.
+ */
+static void seat_node_raise(struct sway_seat *seat,
+		struct sway_seat_node *seat_node) {
+	wl_list_remove(&seat_node->link);
+	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	int64_t order = ++seat->focus_order_top;
+	bool is_view = node_is_view(seat_node->node);
+	seat_node->focus_order = order;
+	seat_node->subtree_order = order;
+	if (is_view) {
+		seat_node->view_order = order;
+	}
+
+	struct sway_seat_node *child = seat_node;
+	struct sway_node *parent = node_get_parent(seat_node->node);
+	for (; parent; parent = node_get_parent(parent)) {
+		struct sway_seat_node *ancestor = seat_node_lookup(seat, parent);
+		if (!ancestor) {
+			break;
+		}
+		if (child == seat_node) {
+			ancestor->active_child = seat_node;
+		}
+		ancestor->subtree_order = order;
+		ancestor->focus_child = child;
+		if (is_view) {
+			ancestor->view_order = order;
+			ancestor->focus_view_child = child;
+		}
+		child = ancestor;
+	}
+}
+
+/**
+ * The most recently focused node in the subtree of the seat node, itself
+ * included.
+ */
+static struct sway_seat_node *seat_node_most_recent(
+		struct sway_seat_node *seat_node) {
+	while (seat_node->focus_child &&
+			seat_node->focus_child->subtree_order > seat_node->focus_order) {
+		seat_node = seat_node->focus_child;
+	}
+	return seat_node;
+}
+
+/**
+ * The most recently focused view in the subtree of the seat node, itself
+ * included.
+ */
+static struct sway_seat_node *seat_node_most_recent_view(
+		struct sway_seat_node *seat_node) {
+	// Views are leaves, so the chain ends at the view
+	while (seat_node && !node_is_view(seat_node->node)) {
+		seat_node = seat_node->focus_view_child;
+	}
+	return seat_node;
+}
+
+/**
+ * Call f with the seat node of every workspace below the node, which must be
+ * the root or an output. Those have no seat nodes, but don't have many
+ * workspaces either.
+ */
+static void for_each_seat_workspace(struct sway_seat *seat,
+		struct sway_node *node,
+		void (*f)(struct sway_seat_node *seat_node, void *data), void *data) {
+	list_t *outputs = root->outputs;
+	struct sway_output *noop = root->noop_output;
+	for (int i = -1; i < outputs->length; ++i) {
+		struct sway_output *output = i < 0 ? noop : outputs->items[i];
+		if (!output || (node->type == N_OUTPUT &&
+					node->sway_output != output)) {
+			continue;
+		}
+		for (int j = 0; j < output->workspaces->length; ++j) {
+			struct sway_workspace *ws = output->workspaces->items[j];
+			struct sway_seat_node *seat_node =
+				seat_node_lookup(seat, &ws->node);
+			if (seat_node) {
+				f(seat_node, data);
+			}
+		}
+	}
+}
+
+static void find_focus_workspace(struct sway_seat_node *seat_node,
+		void *data) {
+	struct sway_seat_node **best = data;
+	if (!*best || seat_node->subtree_order > (*best)->subtree_order) {
+		*best = seat_node;
+	}
+}
+
+static void find_view_workspace(struct sway_seat_node *seat_node, void *data) {
+	struct sway_seat_node **best = data;
+	if (seat_node->view_order != INT64_MIN &&
+			(!*best || seat_node->view_order > (*best)->view_order)) {
+		*best = seat_node;
+	}
+}
+
+static void find_active_workspace(struct sway_seat_node *seat_node,
+		void *data) {
+	struct sway_seat_node **best = data;
+	if (!*best || seat_node->focus_order > (*best)->focus_order) {
+		*best = seat_node;
+	}
+}
+
 void seat_for_each_node(struct sway_seat *seat,
 		void (*f)(struct sway_node *node, void *data), void *data) {
 	struct sway_seat_node *current = NULL;
@@ -127,15 +336,15 @@ struct sway_container *seat_get_focus_inactive_view(struct sway_seat *seat,
 	if (ancestor->type == N_CONTAINER && ancestor->sway_container->view) {
 		return ancestor->sway_container;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node->type == N_CONTAINER && node->sway_container->view &&
-				node_has_ancestor(node, ancestor)) {
-			return node->sway_container;
-		}
+	struct sway_seat_node *seat_node = NULL;
+	if (ancestor->type == N_ROOT || ancestor->type == N_OUTPUT) {
+		for_each_seat_workspace(seat, ancestor, find_view_workspace,
+				&seat_node);
+	} else {
+		seat_node = seat_node_lookup(seat, ancestor);
 	}
-	return NULL;
+	seat_node = seat_node ? seat_node_most_recent_view(seat_node) : NULL;
+	return seat_node ? seat_node->node->sway_container : NULL;
 }
 
 static void handle_seat_node_destroy(struct wl_listener *listener, void *data) {
@@ -221,11 +430,9 @@ static struct sway_seat_node *seat_node_from_node(
 		return NULL;
 	}
 
-	struct sway_seat_node *seat_node = NULL;
-	wl_list_for_each(seat_node, &seat->focus_stack, link) {
-		if (seat_node->node == node) {
-			return seat_node;
-		}
+	struct sway_seat_node *seat_node = seat_node_lookup(seat, node);
+	if (seat_node) {
+		return seat_node;
 	}
 
 	seat_node = calloc(1, sizeof(struct sway_seat_node));
@@ -236,7 +443,11 @@ static struct sway_seat_node *seat_node_from_node(
 
 	seat_node->node = node;
 	seat_node->seat = seat;
+	seat_node->focus_order = --seat->focus_order_bottom;
 	wl_list_insert(seat->focus_stack.prev, &seat_node->link);
+	hash_table_set(seat->focus_nodes, (void *)(uintptr_t)node->id, seat_node);
+	seat_node_summarize(seat, seat_node);
+	seat_node_update_ancestors(seat, node_get_parent(node));
 	wl_signal_add(&node->events.destroy, &seat_node->destroy);
 	seat_node->destroy.notify = handle_seat_node_destroy;
 
@@ -390,8 +601,7 @@ static void collect_focus_iter(struct sway_node *node, void *data) {
 	if (!seat_node) {
 		return;
 	}
-	wl_list_remove(&seat_node->link);
-	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	seat_node_raise(seat, seat_node);
 }
 
 static void collect_focus_workspace_iter(struct sway_workspace *workspace,
@@ -404,6 +614,41 @@ static void collect_focus_container_iter(struct sway_container *container,
 	collect_focus_iter(&container->node, data);
 }
 
+static uint32_t get_current_time_msec(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * Pass the held back motion to the seatop.
+ */
+static void seatop_flush_motion(struct sway_seat *seat) {
+	double dx = seat->seatop_dx, dy = seat->seatop_dy;
+	seat->seatop_dx = seat->seatop_dy = 0;
+	if (seat->seatop_motion_pending) {
+		seat->seatop_motion_pending = false;
+		wl_event_source_timer_update(seat->seatop_motion_timer, 0);
+	}
+	seat->seatop_motion_msec = get_current_time_msec();
+	input_latency_resume(&seat->seatop_motion_latency);
+	seat->seatop_motion_latency.len = 0;
+	seat->seatop_impl->motion(seat, seat->seatop_motion_time, dx, dy);
+	input_latency_end();
+}
+
+static int handle_seatop_motion_timer(void *data) {
+	struct sway_seat *seat = data;
+	if (seat->seatop_motion_pending) {
+		// Keep the held back motion's input events for the transaction
+		input_latency_resume(&seat->seatop_motion_latency);
+		seatop_flush_motion(seat);
+		transaction_commit_dirty();
+		input_latency_end();
+	}
+	return 0;
+}
+
 struct sway_seat *seat_create(const char *seat_name) {
 	struct sway_seat *seat = calloc(1, sizeof(struct sway_seat));
 	if (!seat) {
@@ -426,6 +671,7 @@ struct sway_seat *seat_create(const char *seat_name) {
 
 	// init the focus stack
 	wl_list_init(&seat->focus_stack);
+	seat->focus_nodes = create_hash_table(hash_uint, equal_uint);
 
 	root_for_each_workspace(collect_focus_workspace_iter, seat);
 	root_for_each_container(collect_focus_container_iter, seat);
@@ -459,6 +705,9 @@ struct sway_seat *seat_create(const char *seat_name) {
 
 	wl_list_init(&seat->devices);
 
+	seat->seatop_motion_timer = wl_event_loop_add_timer(server.wl_event_loop,
+			handle_seatop_motion_timer, seat);
+
 	wl_list_insert(&server.input->seats, &seat->link);
 
 	seatop_begin_default(seat);
@@ -783,8 +1032,7 @@ static void set_workspace(struct sway_seat *seat,
 
 void seat_set_raw_focus(struct sway_seat *seat, struct sway_node *node) {
 	struct sway_seat_node *seat_node = seat_node_from_node(seat, node);
-	wl_list_remove(&seat_node->link);
-	wl_list_insert(&seat->focus_stack, &seat_node->link);
+	seat_node_raise(seat, seat_node);
 	node_set_dirty(node);
 	node_set_dirty(node_get_parent(node));
 }
@@ -1033,11 +1281,15 @@ struct sway_node *seat_get_focus_inactive(struct sway_seat *seat,
 	if (node_is_view(node)) {
 		return node;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		if (node_has_ancestor(current->node, node)) {
-			return current->node;
-		}
+	struct sway_seat_node *seat_node = NULL;
+	if (node->type == N_ROOT || node->type == N_OUTPUT) {
+		for_each_seat_workspace(seat, node, find_focus_workspace, &seat_node);
+	} else {
+		seat_node = seat_node_lookup(seat, node);
+		seat_node = seat_node ? seat_node->focus_child : NULL;
+	}
+	if (seat_node) {
+		return seat_node_most_recent(seat_node)->node;
 	}
 	if (node->type == N_WORKSPACE) {
 		return node;
@@ -1045,38 +1297,38 @@ struct sway_node *seat_get_focus_inactive(struct sway_seat *seat,
 	return NULL;
 }
 
-struct sway_container *seat_get_focus_inactive_tiling(struct sway_seat *seat,
-		struct sway_workspace *workspace) {
-	if (!workspace->tiling->length) {
-		return NULL;
-	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node->type == N_CONTAINER &&
-				!container_is_floating_or_child(node->sway_container) &&
-				node->sway_container->workspace == workspace) {
-			return node->sway_container;
+/**
+ * The child with the highest subtree_order, or focus_order if direct is set.
+ */
+static struct sway_seat_node *most_recent_child(struct sway_seat *seat,
+		list_t *children, bool direct) {
+	struct sway_seat_node *best = NULL;
+	for (int i = 0; i < children->length; ++i) {
+		struct sway_container *con = children->items[i];
+		struct sway_seat_node *child = seat_node_lookup(seat, &con->node);
+		if (child && (!best || (direct ?
+					child->focus_order > best->focus_order :
+					child->subtree_order > best->subtree_order))) {
+			best = child;
 		}
 	}
-	return NULL;
+	return best;
+}
+
+struct sway_container *seat_get_focus_inactive_tiling(struct sway_seat *seat,
+		struct sway_workspace *workspace) {
+	struct sway_seat_node *seat_node =
+		most_recent_child(seat, workspace->tiling, false);
+	return seat_node ?
+		seat_node_most_recent(seat_node)->node->sway_container : NULL;
 }
 
 struct sway_container *seat_get_focus_inactive_floating(struct sway_seat *seat,
 		struct sway_workspace *workspace) {
-	if (!workspace->floating->length) {
-		return NULL;
-	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node->type == N_CONTAINER &&
-				container_is_floating_or_child(node->sway_container) &&
-				node->sway_container->workspace == workspace) {
-			return node->sway_container;
-		}
-	}
-	return NULL;
+	struct sway_seat_node *seat_node =
+		most_recent_child(seat, workspace->floating, false);
+	return seat_node ?
+		seat_node_most_recent(seat_node)->node->sway_container : NULL;
 }
 
 struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
@@ -1084,22 +1336,26 @@ struct sway_node *seat_get_active_tiling_child(struct sway_seat *seat,
 	if (node_is_view(parent)) {
 		return parent;
 	}
-	struct sway_seat_node *current;
-	wl_list_for_each(current, &seat->focus_stack, link) {
-		struct sway_node *node = current->node;
-		if (node_get_parent(node) != parent) {
-			continue;
-		}
-		if (parent->type == N_WORKSPACE) {
-			// Only consider tiling children
-			struct sway_workspace *ws = parent->sway_workspace;
-			if (list_find(ws->tiling, node->sway_container) == -1) {
-				continue;
-			}
-		}
-		return node;
+	struct sway_seat_node *seat_node = NULL;
+	switch (parent->type) {
+	case N_ROOT:
+		// Outputs are never in the focus stack
+		return NULL;
+	case N_OUTPUT:
+		for_each_seat_workspace(seat, parent, find_active_workspace,
+				&seat_node);
+		break;
+	case N_WORKSPACE:
+		// Only consider tiling children
+		seat_node = most_recent_child(seat, parent->sway_workspace->tiling,
+				true);
+		break;
+	case N_CONTAINER:
+		seat_node = seat_node_lookup(seat, parent);
+		seat_node = seat_node ? seat_node->active_child : NULL;
+		break;
 	}
-	return NULL;
+	return seat_node ? seat_node->node : NULL;
 }
 
 struct sway_node *seat_get_focus(struct sway_seat *seat) {
@@ -1216,16 +1472,59 @@ void seatop_unref(struct sway_seat *seat, struct sway_container *con) {
 void seatop_button(struct sway_seat *seat, uint32_t time_msec,
 		struct wlr_input_device *device, uint32_t button,
 		enum wlr_button_state state) {
+	if (seat->seatop_motion_pending) {
+		// The seatop may end on release, so finish the motion first
+		seatop_flush_motion(seat);
+	}
 	if (seat->seatop_impl->button) {
 		seat->seatop_impl->button(seat, time_msec, device, button, state);
 	}
 }
 
+/**
+ * Get the interval in milliseconds at which coalesced motion is applied.
+ */
+static uint32_t seatop_motion_interval(struct sway_seat *seat) {
+	int rate = config->interactive_update_rate;
+	if (rate < 0) {
+		struct wlr_output *output = wlr_output_layout_output_at(
+				root->output_layout,
+				seat->cursor->cursor->x, seat->cursor->cursor->y);
+		// The refresh rate is in mHz
+		rate = output && output->refresh > 0 ?
+			(output->refresh + 999) / 1000 : 60;
+	}
+	return rate > 0 ? 1000 / rate : 0;
+}
+
 void seatop_motion(struct sway_seat *seat, uint32_t time_msec,
 		double dx, double dy) {
-	if (seat->seatop_impl->motion) {
+	if (!seat->seatop_impl->motion) {
+		return;
+	}
+	if (!seat->seatop_impl->coalesce_motion) {
 		seat->seatop_impl->motion(seat, time_msec, dx, dy);
+		return;
 	}
+
+	// Only the latest cursor position matters, but moving a floating
+	// container uses the deltas, so add them up
+	seat->seatop_dx += dx;
+	seat->seatop_dy += dy;
+	seat->seatop_motion_time = time_msec;
+	input_latency_carry(&seat->seatop_motion_latency);
+
+	uint32_t elapsed = get_current_time_msec() - seat->seatop_motion_msec;
+	uint32_t interval = seatop_motion_interval(seat);
+	if (elapsed < interval) {
+		if (!seat->seatop_motion_pending) {
+			seat->seatop_motion_pending = true;
+			wl_event_source_timer_update(seat->seatop_motion_timer,
+					interval - elapsed);
+		}
+		return;
+	}
+	seatop_flush_motion(seat);
 }
 
 void seatop_axis(struct sway_seat *seat, struct wlr_event_pointer_axis *event) {
@@ -1241,6 +1540,14 @@ void seatop_rebase(struct sway_seat *seat, uint32_t time_msec) {
 }
 
 void seatop_end(struct sway_seat *seat) {
+	// The seatop may be ending because its container is going away, so drop
+	// any held back motion rather than applying it
+	seat->seatop_dx = seat->seatop_dy = 0;
+	seat->seatop_motion_latency.len = 0;
+	if (seat->seatop_motion_pending) {
+		seat->seatop_motion_pending = false;
+		wl_event_source_timer_update(seat->seatop_motion_timer, 0);
+	}
 	if (seat->seatop_impl && seat->seatop_impl->end) {
 		seat->seatop_impl->end(seat);
 	}
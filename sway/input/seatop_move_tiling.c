@@ -308,6 +308,7 @@ static const struct sway_seatop_impl seatop_impl = {
 	.motion = handle_motion,
 	.unref = handle_unref,
 	.render = handle_render,
+	.coalesce_motion = true,
 };
 
 void seatop_begin_move_tiling_threshold(struct sway_seat *seat,
@@ -127,6 +127,7 @@ static const struct sway_seatop_impl seatop_impl = {
 	.button = handle_button,
 	.motion = handle_motion,
 	.unref = handle_unref,
+	.coalesce_motion = true,
 };
 
 void seatop_begin_resize_floating(struct sway_seat *seat,
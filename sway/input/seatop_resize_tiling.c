@@ -69,6 +69,7 @@ static const struct sway_seatop_impl seatop_impl = {
 	.button = handle_button,
 	.motion = handle_motion,
 	.unref = handle_unref,
+	.coalesce_motion = true,
 };
 
 void seatop_begin_resize_tiling(struct sway_seat *seat,
@@ -5,6 +5,7 @@
 #include "config.h"
 #include "log.h"
 #include "sway/config.h"
+#include "sway/criteria.h"
 #include "sway/ipc-json.h"
 #include "sway/tree/container.h"
 #include "sway/tree/view.h"
@@ -119,6 +120,25 @@ json_object *ipc_json_get_version(void) {
 	return version;
 }
 
+json_object *ipc_json_get_stats(void) {
+	json_object *stats = json_object_new_object();
+
+	struct criteria_cache_stats cache;
+	criteria_cache_get_stats(&cache);
+	json_object *criteria_cache = json_object_new_object();
+	json_object_object_add(criteria_cache, "hits",
+			json_object_new_int64(cache.hits));
+	json_object_object_add(criteria_cache, "misses",
+			json_object_new_int64(cache.misses));
+	json_object_object_add(criteria_cache, "size",
+			json_object_new_int(cache.size));
+	json_object_object_add(criteria_cache, "capacity",
+			json_object_new_int(cache.capacity));
+	json_object_object_add(stats, "criteria_cache", criteria_cache);
+
+	return stats;
+}
+
 static json_object *ipc_json_create_rect(struct wlr_box *box) {
 	json_object *rect = json_object_new_object();
 
@@ -802,6 +822,22 @@ static json_object *describe_libinput_device(struct libinput_device *device) {
 	return object;
 }
 
+static json_object *describe_input_latency(
+		const struct sway_input_latency *latency) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "count",
+			json_object_new_int64(latency->count));
+	json_object_object_add(object, "p50",
+			json_object_new_int(input_latency_percentile(latency, 0.5)));
+	json_object_object_add(object, "p90",
+			json_object_new_int(input_latency_percentile(latency, 0.9)));
+	json_object_object_add(object, "p99",
+			json_object_new_int(input_latency_percentile(latency, 0.99)));
+	json_object_object_add(object, "max",
+			json_object_new_int(latency->max));
+	return object;
+}
+
 json_object *ipc_json_describe_input(struct sway_input_device *device) {
 	if (!(sway_assert(device, "Device must not be null"))) {
 		return NULL;
@@ -849,6 +885,9 @@ json_object *ipc_json_describe_input(struct sway_input_device *device) {
 				describe_libinput_device(libinput_dev));
 	}
 
+	json_object_object_add(object, "latency",
+			describe_input_latency(&device->latency));
+
 	return object;
 }
 
@@ -940,6 +979,8 @@ json_object *ipc_json_describe_bar_config(struct bar_config *bar) {
 			json_object_new_int(bar->status_padding));
 	json_object_object_add(json, "status_edge_padding",
 			json_object_new_int(bar->status_edge_padding));
+	json_object_object_add(json, "status_min_interval",
+			json_object_new_int(bar->status_min_interval));
 	json_object_object_add(json, "wrap_scroll",
 			json_object_new_boolean(bar->wrap_scroll));
 	json_object_object_add(json, "workspace_buttons",
@@ -751,6 +751,16 @@ void ipc_client_handle_command(struct ipc_client *client) {
 		goto exit_cleanup;
 	}
 
+	case IPC_GET_STATS:
+	{
+		json_object *stats = ipc_json_get_stats();
+		const char *json_string = json_object_to_json_string(stats);
+		client_valid =
+			ipc_send_reply(client, json_string, (uint32_t)strlen(json_string));
+		json_object_put(stats); // free
+		goto exit_cleanup;
+	}
+
 	case IPC_GET_TREE:
 	{
 		json_object *tree = ipc_json_describe_node_recursive(&root->node);
@@ -16,6 +16,7 @@
 #include "sway/commands.h"
 #include "sway/config.h"
 #include "sway/debug.h"
+#include "sway/input/keyboard.h"
 #include "sway/server.h"
 #include "sway/swaynag.h"
 #include "sway/tree/root.h"
@@ -212,6 +213,8 @@ void enable_debug_flag(const char *flag) {
 		debug.txn_wait = true;
 	} else if (strcmp(flag, "txn-timings") == 0) {
 		debug.txn_timings = true;
+	} else if (strcmp(flag, "validate-index") == 0) {
+		debug.validate_index = true;
 	} else if (strncmp(flag, "txn-timeout=", 12) == 0) {
 		server.txn_timeout_ms = atoi(&flag[12]);
 	}
@@ -404,6 +407,7 @@ shutdown:
 	sway_log(SWAY_INFO, "Shutting down sway");
 
 	server_fini(&server);
+	sway_keyboard_flush_keymap_cache();
 	root_destroy(root);
 	root = NULL;
 
@@ -142,6 +142,7 @@ bool server_init(struct sway_server *server) {
 
 	server->dirty_nodes = create_list();
 	server->transactions = create_list();
+	server->swaybg_args = create_list();
 
 	server->input = input_manager_create(server);
 	input_manager_get_default_seat(); // create seat0
@@ -158,6 +159,7 @@ void server_fini(struct sway_server *server) {
 	wl_display_destroy(server->wl_display);
 	list_free(server->dirty_nodes);
 	list_free(server->transactions);
+	list_free_items_and_destroy(server->swaybg_args);
 }
 
 bool server_start(struct sway_server *server) {
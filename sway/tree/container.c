@@ -11,6 +11,7 @@
 #include "cairo.h"
 #include "pango.h"
 #include "sway/config.h"
+#include "sway/debug.h"
 #include "sway/desktop.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
@@ -58,6 +59,7 @@ void container_destroy(struct sway_container *con) {
 				"which is still referenced by transactions")) {
 		return;
 	}
+	node_finish(&con->node);
 	free(con->title);
 	free(con->formatted_title);
 	wlr_texture_destroy(con->title_focused);
@@ -86,6 +88,15 @@ void container_destroy(struct sway_container *con) {
 	free(con);
 }
 
+static void container_unindex_marks(struct sway_container *con) {
+	for (int i = 0; i < con->marks->length; ++i) {
+		char *mark = con->marks->items[i];
+		if (hash_table_get(root->marks, mark) == con) {
+			hash_table_del(root->marks, mark);
+		}
+	}
+}
+
 void container_begin_destroy(struct sway_container *con) {
 	if (con->view) {
 		ipc_event_window(con, "close");
@@ -101,6 +112,7 @@ void container_begin_destroy(struct sway_container *con) {
 
 	con->node.destroying = true;
 	node_set_dirty(&con->node);
+	container_unindex_marks(con);
 
 	if (con->scratchpad) {
 		root_scratchpad_remove_container(con);
@@ -288,6 +300,27 @@ static struct sway_container *container_at_linear(struct sway_node *parent,
 
 static struct sway_container *floating_container_at(double lx, double ly,
 		struct wlr_surface **surface, double *sx, double *sy) {
+	struct wlr_output *wlr_output =
+		wlr_output_layout_output_at(root->output_layout, lx, ly);
+	struct sway_output *output = wlr_output ? wlr_output->data : NULL;
+	list_t *floaters = NULL;
+	if (output && output_get_floating_at(output, lx, ly, &floaters)) {
+		for (int i = 0; floaters && i < floaters->length; ++i) {
+			struct sway_container *floater = floaters->items[i];
+			struct wlr_box box = {
+				.x = floater->x,
+				.y = floater->y,
+				.width = floater->width,
+				.height = floater->height,
+			};
+			if (wlr_box_contains_point(&box, lx, ly)) {
+				return tiling_container_at(&floater->node, lx, ly,
+						surface, sx, sy);
+			}
+		}
+		return NULL;
+	}
+
 	for (int i = 0; i < root->outputs->length; ++i) {
 		struct sway_output *output = root->outputs->items[i];
 		for (int j = 0; j < output->workspaces->length; ++j) {
@@ -1236,6 +1269,7 @@ void container_insert_child(struct sway_container *parent,
 	container_for_each_child(child, set_workspace, NULL);
 	container_handle_fullscreen_reparent(child);
 	container_update_representation(parent);
+	input_manager_node_children_changed(&parent->node);
 }
 
 void container_add_sibling(struct sway_container *fixed,
@@ -1251,6 +1285,7 @@ void container_add_sibling(struct sway_container *fixed,
 	container_for_each_child(active, set_workspace, NULL);
 	container_handle_fullscreen_reparent(active);
 	container_update_representation(active);
+	input_manager_node_children_changed(node_get_parent(&active->node));
 }
 
 void container_add_child(struct sway_container *parent,
@@ -1264,6 +1299,7 @@ void container_add_child(struct sway_container *parent,
 	container_for_each_child(child, set_workspace, NULL);
 	container_handle_fullscreen_reparent(child);
 	container_update_representation(parent);
+	input_manager_node_children_changed(&parent->node);
 	node_set_dirty(&child->node);
 	node_set_dirty(&parent->node);
 }
@@ -1291,9 +1327,11 @@ void container_detach(struct sway_container *child) {
 
 	if (old_parent) {
 		container_update_representation(old_parent);
+		input_manager_node_children_changed(&old_parent->node);
 		node_set_dirty(&old_parent->node);
 	} else if (old_workspace) {
 		workspace_update_representation(old_workspace);
+		input_manager_node_children_changed(&old_workspace->node);
 		node_set_dirty(&old_workspace->node);
 	}
 	node_set_dirty(&child->node);
@@ -1342,12 +1380,16 @@ static bool find_by_mark_iterator(struct sway_container *con, void *data) {
 }
 
 struct sway_container *container_find_mark(char *mark) {
-	return root_find_container(find_by_mark_iterator, mark);
+	struct sway_container *con = hash_table_get(root->marks, mark);
+	if (debug.validate_index) {
+		sway_assert(con == root_find_container(find_by_mark_iterator, mark),
+				"Mark index is inconsistent for '%s'", mark);
+	}
+	return con;
 }
 
 bool container_find_and_unmark(char *mark) {
-	struct sway_container *con = root_find_container(
-		find_by_mark_iterator, mark);
+	struct sway_container *con = container_find_mark(mark);
 	if (!con) {
 		return false;
 	}
@@ -1355,8 +1397,12 @@ bool container_find_and_unmark(char *mark) {
 	for (int i = 0; i < con->marks->length; ++i) {
 		char *con_mark = con->marks->items[i];
 		if (strcmp(con_mark, mark) == 0) {
+			hash_table_del(root->marks, con_mark);
 			free(con_mark);
 			list_del(con->marks, i);
+			if (con->view) {
+				view_bump_prop_generation(con->view);
+			}
 			container_update_marks_textures(con);
 			ipc_event_window(con, "mark");
 			return true;
@@ -1366,10 +1412,14 @@ bool container_find_and_unmark(char *mark) {
 }
 
 void container_clear_marks(struct sway_container *con) {
+	container_unindex_marks(con);
 	for (int i = 0; i < con->marks->length; ++i) {
 		free(con->marks->items[i]);
 	}
 	con->marks->length = 0;
+	if (con->view) {
+		view_bump_prop_generation(con->view);
+	}
 	ipc_event_window(con, "mark");
 }
 
@@ -1384,7 +1434,12 @@ bool container_has_mark(struct sway_container *con, char *mark) {
 }
 
 void container_add_mark(struct sway_container *con, char *mark) {
-	list_add(con->marks, strdup(mark));
+	char *dup = strdup(mark);
+	list_add(con->marks, dup);
+	hash_table_set(root->marks, dup, con);
+	if (con->view) {
+		view_bump_prop_generation(con->view);
+	}
 	ipc_event_window(con, "mark");
 }
 
@@ -1,18 +1,53 @@
 #define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include "sway/debug.h"
 #include "sway/output.h"
 #include "sway/server.h"
 #include "sway/tree/container.h"
 #include "sway/tree/node.h"
 #include "sway/tree/root.h"
 #include "sway/tree/workspace.h"
+#include "hash-table.h"
 #include "log.h"
 
+static hash_table_t *nodes_by_id = NULL; // node id -> struct sway_node
+
 void node_init(struct sway_node *node, enum sway_node_type type, void *thing) {
 	static size_t next_id = 1;
 	node->id = next_id++;
 	node->type = type;
 	node->sway_root = thing;
 	wl_signal_init(&node->events.destroy);
+
+	if (!nodes_by_id) {
+		nodes_by_id = create_hash_table(hash_uint, equal_uint);
+	}
+	hash_table_set(nodes_by_id, (void *)(uintptr_t)node->id, node);
+}
+
+void node_finish(struct sway_node *node) {
+	hash_table_del(nodes_by_id, (void *)(uintptr_t)node->id);
+}
+
+static bool find_by_id_iterator(struct sway_container *con, void *data) {
+	size_t *id = data;
+	return con->node.id == *id;
+}
+
+struct sway_node *node_from_id(size_t id) {
+	struct sway_node *node = nodes_by_id ?
+		hash_table_get(nodes_by_id, (void *)(uintptr_t)id) : NULL;
+	if (node && node->destroying) {
+		node = NULL;
+	}
+	if (debug.validate_index) {
+		struct sway_container *con = root_find_container(find_by_id_iterator, &id);
+		if (con || (node && node->type == N_CONTAINER)) {
+			sway_assert(con && node == &con->node,
+					"Node index is inconsistent for ID %zu", id);
+		}
+	}
+	return node;
 }
 
 const char *node_type_to_str(enum sway_node_type type) {
@@ -30,6 +65,7 @@ const char *node_type_to_str(enum sway_node_type type) {
 }
 
 void node_set_dirty(struct sway_node *node) {
+	++root->dirty_serial;
 	if (node->dirty) {
 		return;
 	}
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <strings.h>
 #include <wlr/types/wlr_output_damage.h>
+#include "sway/input/input-manager.h"
 #include "sway/ipc-server.h"
 #include "sway/layers.h"
 #include "sway/output.h"
@@ -216,11 +217,95 @@ void output_destroy(struct sway_output *output) {
 				"which is still referenced by transactions")) {
 		return;
 	}
+	node_finish(&output->node);
+	for (int i = 0; i < OUTPUT_HIT_GRID_SIZE * OUTPUT_HIT_GRID_SIZE; ++i) {
+		list_free(output->hit_grid.cells[i]);
+	}
 	list_free(output->workspaces);
 	list_free(output->current.workspaces);
 	free(output);
 }
 
+static int hit_grid_cell(int origin, int size, double coord) {
+	if (size <= 0) {
+		return 0;
+	}
+	int cell = (coord - origin) * OUTPUT_HIT_GRID_SIZE / size;
+	if (cell < 0) {
+		return 0;
+	}
+	if (cell >= OUTPUT_HIT_GRID_SIZE) {
+		return OUTPUT_HIT_GRID_SIZE - 1;
+	}
+	return cell;
+}
+
+void output_update_hit_grid(struct sway_output *output) {
+	for (int i = 0; i < OUTPUT_HIT_GRID_SIZE * OUTPUT_HIT_GRID_SIZE; ++i) {
+		if (output->hit_grid.cells[i]) {
+			output->hit_grid.cells[i]->length = 0;
+		}
+	}
+	output->hit_grid.serial = root->dirty_serial;
+	output->hit_grid.seat = input_manager_current_seat();
+
+	// Same order as the walk in container_at: floating containers of any
+	// visible workspace can overlap this output
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *other = root->outputs->items[i];
+		for (int j = 0; j < other->workspaces->length; ++j) {
+			struct sway_workspace *ws = other->workspaces->items[j];
+			if (!workspace_is_visible(ws)) {
+				continue;
+			}
+			for (int k = ws->floating->length - 1; k >= 0; --k) {
+				struct sway_container *floater = ws->floating->items[k];
+				struct wlr_box box = {
+					.x = floater->x,
+					.y = floater->y,
+					.width = floater->width,
+					.height = floater->height,
+				};
+				if (box.x >= output->lx + output->width ||
+						box.y >= output->ly + output->height ||
+						box.x + box.width <= output->lx ||
+						box.y + box.height <= output->ly) {
+					continue;
+				}
+				int x0 = hit_grid_cell(output->lx, output->width, box.x);
+				int x1 = hit_grid_cell(output->lx, output->width,
+						box.x + box.width);
+				int y0 = hit_grid_cell(output->ly, output->height, box.y);
+				int y1 = hit_grid_cell(output->ly, output->height,
+						box.y + box.height);
+				for (int y = y0; y <= y1; ++y) {
+					for (int x = x0; x <= x1; ++x) {
+						list_t **cell =
+							&output->hit_grid.cells[y * OUTPUT_HIT_GRID_SIZE + x];
+						if (!*cell) {
+							*cell = create_list();
+						}
+						list_add(*cell, floater);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool output_get_floating_at(struct sway_output *output, double lx, double ly,
+		list_t **floaters) {
+	if (!output->hit_grid.serial ||
+			output->hit_grid.serial != root->dirty_serial ||
+			output->hit_grid.seat != input_manager_current_seat()) {
+		return false;
+	}
+	int x = hit_grid_cell(output->lx, output->width, lx);
+	int y = hit_grid_cell(output->ly, output->height, ly);
+	*floaters = output->hit_grid.cells[y * OUTPUT_HIT_GRID_SIZE + x];
+	return true;
+}
+
 static void untrack_output(struct sway_container *con, void *data) {
 	struct sway_output *output = data;
 	int index = list_find(con->outputs, output);
@@ -240,6 +325,8 @@ void output_disable(struct sway_output *output) {
 
 	root_for_each_container(untrack_output, output);
 
+	// A custom swaybg_command runs per output. The bundled swaybg notices the
+	// output is gone by itself, and draws it again once it's back.
 	if (output->swaybg_client != NULL) {
 		wl_client_destroy(output->swaybg_client);
 	}
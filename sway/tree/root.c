@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#include <ctype.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,6 +24,26 @@ static void output_layout_handle_change(struct wl_listener *listener,
 	transaction_commit_dirty();
 }
 
+// Workspace numbers are compared by the leading digits of their names
+static uint32_t hash_number_prefix(const void *key) {
+	uint32_t hash = 2166136261u;
+	for (const char *c = key; isdigit(*c); ++c) {
+		hash ^= *c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static bool equal_number_prefix(const void *_a, const void *_b) {
+	const char *a = _a, *b = _b;
+	while (isdigit(*a)) {
+		if (*a++ != *b++) {
+			return false;
+		}
+	}
+	return !isdigit(*b);
+}
+
 struct sway_root *root_create(void) {
 	struct sway_root *root = calloc(1, sizeof(struct sway_root));
 	if (!root) {
@@ -31,14 +52,21 @@ struct sway_root *root_create(void) {
 	}
 	node_init(&root->node, N_ROOT, root);
 	root->output_layout = wlr_output_layout_create();
+	root->dirty_serial = 1;
 	wl_list_init(&root->all_outputs);
 #if HAVE_XWAYLAND
 	wl_list_init(&root->xwayland_unmanaged);
 #endif
 	wl_list_init(&root->drag_icons);
+	wl_list_init(&root->urgent_views);
 	wl_signal_init(&root->events.new_node);
 	root->outputs = create_list();
 	root->scratchpad = create_list();
+	root->marks = create_hash_table(hash_string, equal_string);
+	root->workspace_names =
+		create_hash_table(hash_string_nocase, equal_string_nocase);
+	root->workspace_numbers =
+		create_hash_table(hash_number_prefix, equal_number_prefix);
 
 	root->output_layout_change.notify = output_layout_handle_change;
 	wl_signal_add(&root->output_layout->events.change,
@@ -46,14 +74,66 @@ struct sway_root *root_create(void) {
 	return root;
 }
 
+static void free_bucket(const void *key, void *value, void *data) {
+	list_free(value);
+}
+
 void root_destroy(struct sway_root *root) {
+	node_finish(&root->node);
 	wl_list_remove(&root->output_layout_change.link);
 	list_free(root->scratchpad);
 	list_free(root->outputs);
+	hash_table_free(root->marks);
+	hash_table_for_each(root->workspace_names, free_bucket, NULL);
+	hash_table_free(root->workspace_names);
+	hash_table_for_each(root->workspace_numbers, free_bucket, NULL);
+	hash_table_free(root->workspace_numbers);
 	wlr_output_layout_destroy(root->output_layout);
 	free(root);
 }
 
+static void index_add(hash_table_t *table, struct sway_workspace *ws) {
+	list_t *bucket = hash_table_get(table, ws->name);
+	if (!bucket) {
+		bucket = create_list();
+		hash_table_set(table, ws->name, bucket);
+	}
+	list_add(bucket, ws);
+}
+
+static void index_remove(hash_table_t *table, struct sway_workspace *ws) {
+	list_t *bucket = hash_table_get(table, ws->name);
+	int index = bucket ? list_find(bucket, ws) : -1;
+	if (!sway_assert(index != -1, "Workspace '%s' isn't indexed", ws->name)) {
+		return;
+	}
+	list_del(bucket, index);
+	if (bucket->length == 0) {
+		hash_table_del(table, ws->name);
+		list_free(bucket);
+	} else if (index == 0) {
+		// The key belongs to the removed workspace
+		struct sway_workspace *first = bucket->items[0];
+		hash_table_set(table, first->name, bucket);
+	}
+}
+
+void root_index_workspace(struct sway_workspace *ws) {
+	if (!ws->name) {
+		return;
+	}
+	index_add(root->workspace_names, ws);
+	index_add(root->workspace_numbers, ws);
+}
+
+void root_unindex_workspace(struct sway_workspace *ws) {
+	if (!ws->name) {
+		return;
+	}
+	index_remove(root->workspace_names, ws);
+	index_remove(root->workspace_numbers, ws);
+}
+
 void root_scratchpad_add_container(struct sway_container *con) {
 	if (!sway_assert(!con->scratchpad, "Container is already in scratchpad")) {
 		return;
@@ -35,7 +35,9 @@ void view_init(struct sway_view *view, enum sway_view_type type,
 	view->type = type;
 	view->impl = impl;
 	view->executed_criteria = create_list();
+	view->criteria_matches = create_hash_table(hash_uint, equal_uint);
 	view->allow_request_urgent = true;
+	wl_list_init(&view->urgent_link);
 	wl_signal_init(&view->events.unmap);
 }
 
@@ -53,6 +55,7 @@ void view_destroy(struct sway_view *view) {
 		return;
 	}
 	list_free(view->executed_criteria);
+	hash_table_free(view->criteria_matches);
 
 	free(view->title_format);
 
@@ -433,6 +436,10 @@ static bool view_has_executed_criteria(struct sway_view *view,
 	return false;
 }
 
+void view_bump_prop_generation(struct sway_view *view) {
+	++view->prop_generation;
+}
+
 void view_execute_criteria(struct sway_view *view) {
 	list_t *criterias = criteria_for_view(view, CT_COMMAND);
 	for (int i = 0; i < criterias->length; i++) {
@@ -445,7 +452,7 @@ void view_execute_criteria(struct sway_view *view) {
 		sway_log(SWAY_DEBUG, "for_window '%s' matches view %p, cmd: '%s'",
 				criteria->raw, view, criteria->cmdlist);
 		list_add(view->executed_criteria, criteria);
-		list_t *res_list = execute_command(
+		list_t *res_list = execute_cached_command(&criteria->program,
 				criteria->cmdlist, NULL, view->container);
 		while (res_list->length) {
 			struct cmd_results *res = res_list->items[0];
@@ -560,12 +567,33 @@ static bool should_focus(struct sway_view *view) {
 	return len == 0;
 }
 
+static bool urgent_before(struct timespec *a, struct timespec *b) {
+	return a->tv_sec < b->tv_sec ||
+		(a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+static void view_link_urgent(struct sway_view *view) {
+	// Usually the view is the latest urgent one, so search from the end
+	struct wl_list *prev = root->urgent_views.prev;
+	while (prev != &root->urgent_views) {
+		struct sway_view *other = wl_container_of(prev, other, urgent_link);
+		if (!urgent_before(&view->urgent, &other->urgent)) {
+			break;
+		}
+		prev = prev->prev;
+	}
+	wl_list_insert(prev, &view->urgent_link);
+}
+
 void view_map(struct sway_view *view, struct wlr_surface *wlr_surface,
 			  bool fullscreen, bool decoration) {
 	if (!sway_assert(view->surface == NULL, "cannot map mapped view")) {
 		return;
 	}
 	view->surface = wlr_surface;
+	// The title and app_id aren't tracked while unmapped, and the marks went
+	// with the old container, so criteria results from before are stale
+	view_bump_prop_generation(view);
 
 	struct sway_seat *seat = input_manager_current_seat();
 	struct sway_workspace *ws = select_workspace(view);
@@ -630,6 +658,10 @@ void view_map(struct sway_view *view, struct wlr_surface *wlr_surface,
 		}
 	}
 
+	if (view_is_urgent(view)) {
+		view_link_urgent(view);
+	}
+
 	view_execute_criteria(view);
 
 	if (should_focus(view)) {
@@ -646,6 +678,8 @@ void view_unmap(struct sway_view *view) {
 		wl_event_source_remove(view->urgent_timer);
 		view->urgent_timer = NULL;
 	}
+	wl_list_remove(&view->urgent_link);
+	wl_list_init(&view->urgent_link);
 
 	struct sway_container *parent = view->container->parent;
 	struct sway_workspace *ws = view->container->workspace;
@@ -1015,10 +1049,8 @@ void view_update_title(struct sway_view *view, bool force) {
 	ipc_event_window(view->container, "title");
 }
 
-bool view_is_visible(struct sway_view *view) {
-	if (view->container->node.destroying) {
-		return false;
-	}
+static bool view_compute_visibility(struct sway_view *view,
+		struct sway_seat *seat) {
 	struct sway_workspace *workspace = view->container->workspace;
 	if (!workspace) {
 		return false;
@@ -1033,7 +1065,6 @@ bool view_is_visible(struct sway_view *view) {
 		return false;
 	}
 	// Check view isn't in a tabbed or stacked container on an inactive tab
-	struct sway_seat *seat = input_manager_current_seat();
 	struct sway_container *con = view->container;
 	while (con) {
 		enum sway_container_layout layout = container_parent_layout(con);
@@ -1057,6 +1088,28 @@ bool view_is_visible(struct sway_view *view) {
 	return true;
 }
 
+bool view_update_visibility(struct sway_view *view) {
+	bool was_visible = view->visible;
+	struct sway_seat *seat = input_manager_current_seat();
+	view->visible = view_compute_visibility(view, seat);
+	view->visible_serial = root->dirty_serial;
+	view->visible_seat = seat;
+	return view->visible != was_visible;
+}
+
+bool view_is_visible(struct sway_view *view) {
+	if (view->container->node.destroying) {
+		return false;
+	}
+	// Focus changes mark the affected nodes dirty, so this also covers the
+	// active tab of tabbed and stacked containers
+	if (view->visible_serial != root->dirty_serial ||
+			view->visible_seat != input_manager_current_seat()) {
+		view_update_visibility(view);
+	}
+	return view->visible;
+}
+
 void view_set_urgent(struct sway_view *view, bool enable) {
 	if (view_is_urgent(view) == enable) {
 		return;
@@ -1067,8 +1120,11 @@ void view_set_urgent(struct sway_view *view, bool enable) {
 			return;
 		}
 		clock_gettime(CLOCK_MONOTONIC, &view->urgent);
+		view_link_urgent(view);
 	} else {
 		view->urgent = (struct timespec){ 0 };
+		wl_list_remove(&view->urgent_link);
+		wl_list_init(&view->urgent_link);
 		if (view->urgent_timer) {
 			wl_event_source_remove(view->urgent_timer);
 			view->urgent_timer = NULL;
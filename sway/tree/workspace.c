@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <strings.h>
 #include "stringop.h"
+#include "sway/debug.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/cursor.h"
 #include "sway/input/seat.h"
@@ -85,6 +86,7 @@ struct sway_workspace *workspace_create(struct sway_output *output,
 	}
 	node_init(&ws->node, N_WORKSPACE, ws);
 	ws->name = name ? strdup(name) : NULL;
+	root_index_workspace(ws);
 	ws->prev_split_layout = L_NONE;
 	ws->layout = output_get_default_layout(output);
 	ws->floating = create_list();
@@ -147,6 +149,7 @@ void workspace_destroy(struct sway_workspace *workspace) {
 		return;
 	}
 
+	node_finish(&workspace->node);
 	free(workspace->name);
 	free(workspace->representation);
 	list_free_items_and_destroy(workspace->output_priority);
@@ -165,6 +168,7 @@ void workspace_begin_destroy(struct sway_workspace *workspace) {
 	if (workspace->output) {
 		workspace_detach(workspace);
 	}
+	root_unindex_workspace(workspace);
 	workspace->node.destroying = true;
 	node_set_dirty(&workspace->node);
 }
@@ -356,14 +360,47 @@ static bool _workspace_by_number(struct sway_workspace *ws, void *data) {
 	return !isdigit(*ws_name);
 }
 
-struct sway_workspace *workspace_by_number(const char* name) {
-	return root_find_workspace(_workspace_by_number, (void *) name);
-}
-
 static bool _workspace_by_name(struct sway_workspace *ws, void *data) {
 	return strcasecmp(ws->name, data) == 0;
 }
 
+/**
+ * Return the workspace from an index bucket that root_find_workspace would
+ * find, ie. the first one in output and workspace order on an enabled output.
+ */
+static struct sway_workspace *find_indexed_workspace(hash_table_t *index,
+		const char *name, bool (*test)(struct sway_workspace *, void *)) {
+	list_t *bucket = hash_table_get(index, name);
+	struct sway_workspace *result = NULL;
+	int result_output = -1, result_index = -1;
+	for (int i = 0; bucket && i < bucket->length; ++i) {
+		struct sway_workspace *ws = bucket->items[i];
+		int output_index = ws->output ?
+			list_find(root->outputs, ws->output) : -1;
+		if (output_index < 0) {
+			continue;
+		}
+		int ws_index = list_find(ws->output->workspaces, ws);
+		if (!result || output_index < result_output ||
+				(output_index == result_output && ws_index < result_index)) {
+			result = ws;
+			result_output = output_index;
+			result_index = ws_index;
+		}
+	}
+	if (debug.validate_index) {
+		struct sway_workspace *ws = root_find_workspace(test, (void *)name);
+		sway_assert(ws == result,
+				"Workspace index is inconsistent for '%s'", name);
+	}
+	return result;
+}
+
+struct sway_workspace *workspace_by_number(const char* name) {
+	return find_indexed_workspace(root->workspace_numbers, name,
+			_workspace_by_number);
+}
+
 struct sway_workspace *workspace_by_name(const char *name) {
 	struct sway_seat *seat = input_manager_current_seat();
 	struct sway_workspace *current = seat_get_focused_workspace(seat);
@@ -383,10 +420,11 @@ struct sway_workspace *workspace_by_name(const char *name) {
 		if (!seat->prev_workspace_name) {
 			return NULL;
 		}
-		return root_find_workspace(_workspace_by_name,
-				(void*)seat->prev_workspace_name);
+		return find_indexed_workspace(root->workspace_names,
+				seat->prev_workspace_name, _workspace_by_name);
 	} else {
-		return root_find_workspace(_workspace_by_name, (void*)name);
+		return find_indexed_workspace(root->workspace_names, name,
+				_workspace_by_name);
 	}
 }
 
@@ -665,6 +703,7 @@ void workspace_add_tiling(struct sway_workspace *workspace,
 	con->workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
 	container_handle_fullscreen_reparent(con);
+	input_manager_node_children_changed(&workspace->node);
 	workspace_update_representation(workspace);
 	node_set_dirty(&workspace->node);
 	node_set_dirty(&con->node);
@@ -679,6 +718,7 @@ void workspace_add_floating(struct sway_workspace *workspace,
 	con->workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
 	container_handle_fullscreen_reparent(con);
+	input_manager_node_children_changed(&workspace->node);
 	node_set_dirty(&workspace->node);
 	node_set_dirty(&con->node);
 }
@@ -692,6 +732,7 @@ void workspace_insert_tiling(struct sway_workspace *workspace,
 	con->workspace = workspace;
 	container_for_each_child(con, set_workspace, NULL);
 	container_handle_fullscreen_reparent(con);
+	input_manager_node_children_changed(&workspace->node);
 	workspace_update_representation(workspace);
 	node_set_dirty(&workspace->node);
 	node_set_dirty(&con->node);
@@ -56,8 +56,8 @@ static void swaybar_output_free(struct swaybar_output *output) {
 	}
 	zxdg_output_v1_destroy(output->xdg_output);
 	wl_output_destroy(output->output);
-	destroy_buffer(&output->buffers[0]);
-	destroy_buffer(&output->buffers[1]);
+	finish_buffer_pool(&output->buffer_pool);
+	free_render_cache(output);
 	free_hotspots(&output->hotspots);
 	free_workspaces(&output->workspaces);
 	wl_list_remove(&output->link);
@@ -66,11 +66,22 @@ static void swaybar_output_free(struct swaybar_output *output) {
 	free(output);
 }
 
+/**
+ * Marks the output to be rendered. Outputs are rendered once all pending
+ * events have been handled, or at the next frame callback if a frame is
+ * still pending, so several updates in a row only cost one frame.
+ */
 static void set_output_dirty(struct swaybar_output *output) {
-	if (output->frame_scheduled) {
-		output->dirty = true;
-	} else if (output->surface) {
-		render_frame(output);
+	output->dirty = true;
+}
+
+static void render_dirty_outputs(struct swaybar *bar) {
+	struct swaybar_output *output;
+	wl_list_for_each(output, &bar->outputs, link) {
+		if (output->dirty && !output->frame_scheduled && output->surface) {
+			output->dirty = false;
+			render_frame(output);
+		}
 	}
 }
 
@@ -260,6 +271,10 @@ static void xdg_output_handle_done(void *data,
 		output->surface = wl_compositor_create_surface(bar->compositor);
 		assert(output->surface);
 
+		// Workspace events for the output may have come before it did
+		if (bar->config->workspace_buttons && bar->running) {
+			ipc_get_workspaces(bar);
+		}
 		determine_bar_visibility(bar, false);
 	}
 }
@@ -332,6 +347,9 @@ static void handle_global(void *data, struct wl_registry *registry,
 		wl_output_add_listener(output->output, &output_listener, output);
 		output->scale = 1;
 		output->wl_name = name;
+		// A third buffer so that a frame isn't dropped while the
+		// compositor holds on to the other two
+		init_buffer_pool(&output->buffer_pool, 3);
 		wl_list_init(&output->workspaces);
 		wl_list_init(&output->hotspots);
 		wl_list_init(&output->link);
@@ -427,15 +445,36 @@ static void ipc_in(int fd, short mask, void *data) {
 	}
 }
 
+static void status_in(int fd, short mask, void *data);
+
+static void status_timer_done(void *data) {
+	struct swaybar *bar = data;
+	bar->status_timer = NULL;
+	if (bar->status->read_fd != -1) {
+		loop_add_fd(bar->eventloop, bar->status->read_fd, POLLIN,
+				status_in, bar);
+	}
+}
+
 static void status_in(int fd, short mask, void *data) {
 	struct swaybar *bar = data;
 	if (mask & (POLLHUP | POLLERR)) {
 		status_error(bar->status, "[error reading from status command]");
 		set_bar_dirty(bar);
 		loop_remove_fd(bar->eventloop, fd);
-	} else if (status_handle_readable(bar->status)) {
+		return;
+	}
+	if (status_handle_readable(bar->status)) {
 		set_bar_dirty(bar);
 	}
+	// Leave whatever the status command writes next in the pipe until the
+	// interval is over, then only the newest status line is used
+	int interval = bar->config->status_min_interval;
+	if (interval > 0 && bar->status->read_fd != -1) {
+		loop_remove_fd(bar->eventloop, fd);
+		bar->status_timer = loop_add_timer(bar->eventloop, interval,
+				status_timer_done, bar);
+	}
 }
 
 void bar_run(struct swaybar *bar) {
@@ -453,6 +492,7 @@ void bar_run(struct swaybar *bar) {
 #endif
 	while (bar->running) {
 		errno = 0;
+		render_dirty_outputs(bar);
 		if (wl_display_flush(bar->display) == -1 && errno != EAGAIN) {
 			break;
 		}
@@ -477,6 +517,9 @@ void bar_teardown(struct swaybar *bar) {
 	}
 	close(bar->ipc_event_socketfd);
 	close(bar->ipc_socketfd);
+	if (bar->status_timer) {
+		loop_remove_timer(bar->eventloop, bar->status_timer);
+	}
 	if (bar->status) {
 		status_line_free(bar->status);
 	}
@@ -1,7 +1,7 @@
 #define _POSIX_C_SOURCE 200809L
 #include <json.h>
 #include <linux/input-event-codes.h>
-#include <ctype.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -9,6 +9,7 @@
 #include "swaybar/bar.h"
 #include "swaybar/config.h"
 #include "swaybar/i3bar.h"
+#include "swaybar/i3bar_parser.h"
 #include "swaybar/input.h"
 #include "swaybar/status_line.h"
 
@@ -29,220 +30,227 @@ void i3bar_block_unref(struct i3bar_block *block) {
 	}
 }
 
-static void i3bar_parse_json(struct status_line *status,
-		struct json_object *json_array) {
-	struct i3bar_block *block, *tmp;
-	wl_list_for_each_safe(block, tmp, &status->blocks, link) {
-		wl_list_remove(&block->link);
-		i3bar_block_unref(block);
+static bool update_string(char **field, const char *value) {
+	if (*field == value || (*field && value && strcmp(*field, value) == 0)) {
+		return false;
 	}
-	for (size_t i = 0; i < json_object_array_length(json_array); ++i) {
-		json_object *full_text, *short_text, *color, *min_width, *align, *urgent;
-		json_object *name, *instance, *separator, *separator_block_width;
-		json_object *background, *border, *border_top, *border_bottom;
-		json_object *border_left, *border_right, *markup;
-		json_object *json = json_object_array_get_idx(json_array, i);
-		if (!json) {
-			continue;
-		}
-		json_object_object_get_ex(json, "full_text", &full_text);
-		json_object_object_get_ex(json, "short_text", &short_text);
-		json_object_object_get_ex(json, "color", &color);
-		json_object_object_get_ex(json, "min_width", &min_width);
-		json_object_object_get_ex(json, "align", &align);
-		json_object_object_get_ex(json, "urgent", &urgent);
-		json_object_object_get_ex(json, "name", &name);
-		json_object_object_get_ex(json, "instance", &instance);
-		json_object_object_get_ex(json, "markup", &markup);
-		json_object_object_get_ex(json, "separator", &separator);
-		json_object_object_get_ex(json, "separator_block_width", &separator_block_width);
-		json_object_object_get_ex(json, "background", &background);
-		json_object_object_get_ex(json, "border", &border);
-		json_object_object_get_ex(json, "border_top", &border_top);
-		json_object_object_get_ex(json, "border_bottom", &border_bottom);
-		json_object_object_get_ex(json, "border_left", &border_left);
-		json_object_object_get_ex(json, "border_right", &border_right);
+	free(*field);
+	*field = value ? strdup(value) : NULL;
+	return true;
+}
+
+static bool update_int(int *field, int value) {
+	bool changed = *field != value;
+	*field = value;
+	return changed;
+}
+
+static bool update_bool(bool *field, bool value) {
+	bool changed = *field != value;
+	*field = value;
+	return changed;
+}
 
-		struct i3bar_block *block = calloc(1, sizeof(struct i3bar_block));
-		block->ref_count = 1;
-		block->full_text = full_text ?
-			strdup(json_object_get_string(full_text)) : NULL;
-		block->short_text = short_text ?
-			strdup(json_object_get_string(short_text)) : NULL;
-		if (color) {
+static bool update_color(uint32_t *field, uint32_t value) {
+	bool changed = *field != value;
+	*field = value;
+	return changed;
+}
+
+static bool strings_equal(const char *a, const char *b) {
+	return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+/**
+ * Updates the block from the parsed block, returning true if anything
+ * changed.
+ */
+static bool i3bar_block_update(struct i3bar_block *block,
+		struct i3bar_line *line, struct i3bar_parsed_block *parsed) {
+	struct i3bar_value *fields = parsed->fields;
+	bool changed = false;
+	changed |= update_string(&block->full_text,
+			i3bar_value_string(line, &fields[I3BAR_FULL_TEXT]));
+	changed |= update_string(&block->short_text,
+			i3bar_value_string(line, &fields[I3BAR_SHORT_TEXT]));
+	const char *color = i3bar_value_string(line, &fields[I3BAR_COLOR]);
+	if (color) {
+		uint32_t value = parse_color(color);
+		if (!block->color) {
 			block->color = malloc(sizeof(uint32_t));
-			*block->color = parse_color(json_object_get_string(color));
-		}
-		if (min_width) {
-			json_type type = json_object_get_type(min_width);
-			if (type == json_type_int) {
-				block->min_width = json_object_get_int(min_width);
-			} else if (type == json_type_string) {
-				/* the width will be calculated when rendering */
-				block->min_width_str = strdup(json_object_get_string(min_width));
-			}
+			*block->color = value;
+			changed = true;
+		} else {
+			changed |= update_color(block->color, value);
 		}
-		block->align = strdup(align ? json_object_get_string(align) : "left");
-		block->urgent = urgent ? json_object_get_int(urgent) : false;
-		block->name = name ? strdup(json_object_get_string(name)) : NULL;
-		block->instance = instance ?
-			strdup(json_object_get_string(instance)) : NULL;
-		if (markup) {
-			block->markup = false;
-			const char *markup_str = json_object_get_string(markup);
-			if (strcmp(markup_str, "pango") == 0) {
-				block->markup = true;
+	} else if (block->color) {
+		free(block->color);
+		block->color = NULL;
+		changed = true;
+	}
+	struct i3bar_value *min_width = &fields[I3BAR_MIN_WIDTH];
+	if (min_width->type == I3BAR_VALUE_STRING) {
+		/* the width will be calculated when rendering */
+		changed |= update_string(&block->min_width_str,
+				i3bar_value_string(line, min_width));
+	} else {
+		changed |= update_string(&block->min_width_str, NULL);
+		changed |= update_int(&block->min_width,
+				i3bar_value_is_int(line, min_width) ?
+				i3bar_value_int(line, min_width) : 0);
+	}
+	const char *align = i3bar_value_string(line, &fields[I3BAR_ALIGN]);
+	changed |= update_string(&block->align, align ? align : "left");
+	changed |= update_bool(&block->urgent,
+			i3bar_value_int(line, &fields[I3BAR_URGENT]));
+	changed |= update_string(&block->name,
+			i3bar_value_string(line, &fields[I3BAR_NAME]));
+	changed |= update_string(&block->instance,
+			i3bar_value_string(line, &fields[I3BAR_INSTANCE]));
+	const char *markup = i3bar_value_string(line, &fields[I3BAR_MARKUP]);
+	changed |= update_bool(&block->markup,
+			markup && strcmp(markup, "pango") == 0);
+	struct i3bar_value *separator = &fields[I3BAR_SEPARATOR];
+	changed |= update_bool(&block->separator,
+			separator->type == I3BAR_VALUE_NONE ||
+			i3bar_value_int(line, separator));
+	struct i3bar_value *separator_block_width =
+		&fields[I3BAR_SEPARATOR_BLOCK_WIDTH];
+	changed |= update_int(&block->separator_block_width,
+			separator_block_width->type == I3BAR_VALUE_NONE ? 9 :
+			i3bar_value_int(line, separator_block_width));
+	// Airblader features
+	const char *background =
+		i3bar_value_string(line, &fields[I3BAR_BACKGROUND]);
+	changed |= update_color(&block->background,
+			background ? parse_color(background) : 0);
+	const char *border = i3bar_value_string(line, &fields[I3BAR_BORDER]);
+	changed |= update_color(&block->border, border ? parse_color(border) : 0);
+	static const enum i3bar_field border_fields[] = {
+		I3BAR_BORDER_TOP,
+		I3BAR_BORDER_BOTTOM,
+		I3BAR_BORDER_LEFT,
+		I3BAR_BORDER_RIGHT,
+	};
+	int *border_widths[] = {
+		&block->border_top,
+		&block->border_bottom,
+		&block->border_left,
+		&block->border_right,
+	};
+	for (size_t i = 0; i < sizeof(border_fields) / sizeof(border_fields[0]);
+			++i) {
+		struct i3bar_value *value = &fields[border_fields[i]];
+		changed |= update_int(border_widths[i],
+				value->type == I3BAR_VALUE_NONE ? 1 :
+				i3bar_value_int(line, value));
+	}
+	return changed;
+}
+
+/**
+ * Finds the block the parsed block describes among the blocks of the last
+ * status line: by name and instance if it has a name, otherwise by position.
+ */
+static struct i3bar_block *find_old_block(struct i3bar_block **old_blocks,
+		size_t old_len, size_t index, struct i3bar_line *line,
+		struct i3bar_parsed_block *parsed, size_t *old_index) {
+	const char *name =
+		i3bar_value_string(line, &parsed->fields[I3BAR_NAME]);
+	const char *instance =
+		i3bar_value_string(line, &parsed->fields[I3BAR_INSTANCE]);
+	if (name) {
+		for (size_t i = 0; i < old_len; ++i) {
+			struct i3bar_block *block = old_blocks[i];
+			if (block && strings_equal(block->name, name) &&
+					strings_equal(block->instance, instance)) {
+				old_blocks[i] = NULL;
+				*old_index = i;
+				return block;
 			}
 		}
-		block->separator = separator ? json_object_get_int(separator) : true;
-		block->separator_block_width = separator_block_width ?
-			json_object_get_int(separator_block_width) : 9;
-		// Airblader features
-		block->background = background ?
-			parse_color(json_object_get_string(background)) : 0;
-		block->border = border ? 
-			parse_color(json_object_get_string(border)) : 0;
-		block->border_top = border_top ? json_object_get_int(border_top) : 1;
-		block->border_bottom = border_bottom ?
-			json_object_get_int(border_bottom) : 1;
-		block->border_left = border_left ? json_object_get_int(border_left) : 1;
-		block->border_right = border_right ?
-			json_object_get_int(border_right) : 1;
-		wl_list_insert(&status->blocks, &block->link);
 	}
+	if (index < old_len && old_blocks[index] && !old_blocks[index]->name) {
+		struct i3bar_block *block = old_blocks[index];
+		old_blocks[index] = NULL;
+		*old_index = index;
+		return block;
+	}
+	return NULL;
 }
 
-bool i3bar_handle_readable(struct status_line *status) {
-	while (!status->started) { // look for opening bracket
-		for (size_t c = 0; c < status->buffer_index; ++c) {
-			if (status->buffer[c] == '[') {
-				status->started = true;
-				status->buffer_index -= ++c;
-				memmove(status->buffer, &status->buffer[c], status->buffer_index);
-				break;
-			} else if (!isspace(status->buffer[c])) {
-				sway_log(SWAY_DEBUG, "Invalid i3bar json: expected '[' but encountered '%c'",
-						status->buffer[c]);
-				status_error(status, "[invalid i3bar json]");
-				return true;
-			}
+/**
+ * Updates the blocks to the status line, reusing the blocks it had before.
+ * Returns true if anything changed.
+ */
+static bool i3bar_apply_line(struct status_line *status,
+		struct i3bar_line *line) {
+	// Blocks are kept in reverse order, the last one first
+	size_t old_len = wl_list_length(&status->blocks);
+	struct i3bar_block **old_blocks =
+		calloc(old_len, sizeof(struct i3bar_block *));
+	if (old_len && !old_blocks) {
+		sway_log(SWAY_ERROR, "Failed to allocate i3bar block array");
+		return false;
+	}
+	size_t n = old_len;
+	struct i3bar_block *old, *tmp;
+	wl_list_for_each_safe(old, tmp, &status->blocks, link) {
+		old_blocks[--n] = old;
+		wl_list_remove(&old->link);
+	}
+	wl_list_init(&status->blocks);
+
+	bool changed = false;
+	for (size_t i = 0; i < line->len; ++i) {
+		struct i3bar_parsed_block *parsed = &line->blocks[i];
+		size_t old_index;
+		struct i3bar_block *block = find_old_block(old_blocks, old_len, i,
+				line, parsed, &old_index);
+		if (block) {
+			changed |= old_index != i;
+		} else {
+			block = calloc(1, sizeof(struct i3bar_block));
+			block->ref_count = 1;
+			changed = true;
 		}
-		if (status->started) {
-			break;
+		changed |= i3bar_block_update(block, line, parsed);
+		wl_list_insert(&status->blocks, &block->link);
+	}
+
+	for (size_t i = 0; i < old_len; ++i) {
+		if (old_blocks[i]) {
+			i3bar_block_unref(old_blocks[i]);
+			changed = true;
 		}
+	}
+	free(old_blocks);
+	return changed;
+}
 
-		errno = 0;
-		ssize_t read_bytes = read(status->read_fd, status->buffer, status->buffer_size);
-		if (read_bytes > -1) {
-			status->buffer_index = read_bytes;
-		} else if (errno == EAGAIN) {
-			return false;
-		} else {
-			status_error(status, "[error reading from status command]");
+bool i3bar_handle_readable(struct status_line *status) {
+	// Whatever followed the header was read along with it
+	if (status->buffer_index > 0) {
+		size_t len = status->buffer_index;
+		status->buffer_index = 0;
+		if (!i3bar_parser_feed(&status->parser, status->buffer, len)) {
+			status_error(status, "[failed to parse i3bar json]");
 			return true;
 		}
 	}
 
-	struct json_object *last_object = NULL;
-	struct json_object *test_object;
-	size_t buffer_pos = 0;
 	while (true) {
-		// since the incoming stream is an infinite array
-		// parsing is split into two parts
-		// first, attempt to parse the current object, reading more if the
-		// parser indicates that the current object is incomplete, and failing
-		// if the parser fails
-		// second, look for separating comma, ignoring whitespace, failing if
-		// any other characters are encountered
-		if (status->expecting_comma) {
-			for (; buffer_pos < status->buffer_index; ++buffer_pos) {
-				if (status->buffer[buffer_pos] == ',') {
-					status->expecting_comma = false;
-					++buffer_pos;
-					break;
-				} else if (!isspace(status->buffer[buffer_pos])) {
-					sway_log(SWAY_DEBUG, "Invalid i3bar json: expected ',' but encountered '%c'",
-							status->buffer[buffer_pos]);
-					status_error(status, "[invalid i3bar json]");
-					return true;
-				}
-			}
-			if (buffer_pos < status->buffer_index) {
-				continue; // look for new object without reading more input
-			}
-			buffer_pos = status->buffer_index = 0;
-		} else {
-			test_object = json_tokener_parse_ex(status->tokener,
-					&status->buffer[buffer_pos], status->buffer_index - buffer_pos);
-			enum json_tokener_error err = json_tokener_get_error(status->tokener);
-			if (err == json_tokener_success) {
-				if (json_object_get_type(test_object) == json_type_array) {
-					if (last_object) {
-						json_object_put(last_object);
-					}
-					last_object = test_object;
-				} else {
-					json_object_put(test_object);
-				}
-
-				// in order to print the json for debugging purposes
-				// the last character is temporarily replaced with a null character
-				// (the last character is used in case the buffer is full)
-				char *last_char_pos =
-					&status->buffer[buffer_pos + status->tokener->char_offset - 1];
-				char last_char = *last_char_pos;
-				while (isspace(last_char)) {
-					last_char = *--last_char_pos;
-				}
-				*last_char_pos = '\0';
-				size_t offset = strspn(&status->buffer[buffer_pos], " \f\n\r\t\v");
-				sway_log(SWAY_DEBUG, "Received i3bar json: '%s%c'",
-						&status->buffer[buffer_pos + offset], last_char);
-				*last_char_pos = last_char;
-
-				buffer_pos += status->tokener->char_offset;
-				status->expecting_comma = true;
-
-				if (buffer_pos < status->buffer_index) {
-					continue; // look for comma without reading more input
-				}
-				buffer_pos = status->buffer_index = 0;
-			} else if (err == json_tokener_continue) {
-				json_tokener_reset(status->tokener);
-				if (status->buffer_index < status->buffer_size) {
-					// move the object to the start of the buffer
-					status->buffer_index -= buffer_pos;
-					memmove(status->buffer, &status->buffer[buffer_pos],
-							status->buffer_index);
-					buffer_pos = 0;
-				} else {
-					// expand buffer
-					status->buffer_size *= 2;
-					char *new_buffer = realloc(status->buffer, status->buffer_size);
-					if (new_buffer) {
-						status->buffer = new_buffer;
-					} else {
-						free(status->buffer);
-						status_error(status, "[failed to allocate buffer]");
-						return true;
-					}
-				}
-			} else {
-				char last_char = status->buffer[status->buffer_index - 1];
-				status->buffer[status->buffer_index - 1] = '\0';
-				sway_log(SWAY_DEBUG, "Failed to parse i3bar json - %s: '%s%c'",
-						json_tokener_error_desc(err), &status->buffer[buffer_pos], last_char);
+		errno = 0;
+		ssize_t read_bytes =
+			read(status->read_fd, status->buffer, status->buffer_size);
+		if (read_bytes > 0) {
+			if (!i3bar_parser_feed(&status->parser, status->buffer,
+						read_bytes)) {
+				sway_log(SWAY_DEBUG, "Failed to parse i3bar json");
 				status_error(status, "[failed to parse i3bar json]");
 				return true;
 			}
-		}
-
-		errno = 0;
-		ssize_t read_bytes = read(status->read_fd, &status->buffer[status->buffer_index],
-				status->buffer_size - status->buffer_index);
-		if (read_bytes > -1) {
-			status->buffer_index += read_bytes;
-		} else if (errno == EAGAIN) {
+		} else if (read_bytes == 0 || errno == EAGAIN) {
 			break;
 		} else {
 			status_error(status, "[error reading from status command]");
@@ -250,14 +258,15 @@ bool i3bar_handle_readable(struct status_line *status) {
 		}
 	}
 
-	if (last_object) {
-		sway_log(SWAY_DEBUG, "Rendering last received json");
-		i3bar_parse_json(status, last_object);
-		json_object_put(last_object);
-		return true;
-	} else {
+	// Only the last status line received matters
+	struct i3bar_line *line = i3bar_parser_take_line(&status->parser);
+	if (!line) {
 		return false;
 	}
+	bool changed = i3bar_apply_line(status, line);
+	sway_log(SWAY_DEBUG, "Received i3bar status line with %zu blocks%s",
+			line->len, changed ? "" : ", unchanged");
+	return changed;
 }
 
 enum hotspot_event_handling i3bar_block_send_click(struct status_line *status,
@@ -0,0 +1,565 @@
+#define _POSIX_C_SOURCE 200809L
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "swaybar/i3bar_parser.h"
+
+// Nesting of the containers the parser cares about
+enum {
+	DEPTH_STREAM = 0, // the infinite array
+	DEPTH_LINE = 1, // a status line array
+	DEPTH_BLOCK = 2, // a block object
+	DEPTH_FIELD = 3, // the value of a block field
+};
+
+static const char *field_names[I3BAR_FIELD_COUNT] = {
+	[I3BAR_FULL_TEXT] = "full_text",
+	[I3BAR_SHORT_TEXT] = "short_text",
+	[I3BAR_COLOR] = "color",
+	[I3BAR_MIN_WIDTH] = "min_width",
+	[I3BAR_ALIGN] = "align",
+	[I3BAR_URGENT] = "urgent",
+	[I3BAR_NAME] = "name",
+	[I3BAR_INSTANCE] = "instance",
+	[I3BAR_SEPARATOR] = "separator",
+	[I3BAR_SEPARATOR_BLOCK_WIDTH] = "separator_block_width",
+	[I3BAR_MARKUP] = "markup",
+	[I3BAR_BACKGROUND] = "background",
+	[I3BAR_BORDER] = "border",
+	[I3BAR_BORDER_TOP] = "border_top",
+	[I3BAR_BORDER_BOTTOM] = "border_bottom",
+	[I3BAR_BORDER_LEFT] = "border_left",
+	[I3BAR_BORDER_RIGHT] = "border_right",
+};
+
+void i3bar_parser_init(struct i3bar_parser *parser) {
+	memset(parser, 0, sizeof(struct i3bar_parser));
+	parser->expect = I3BAR_EXPECT_VALUE;
+	parser->field = -1;
+}
+
+void i3bar_parser_finish(struct i3bar_parser *parser) {
+	for (size_t i = 0; i < sizeof(parser->lines) / sizeof(parser->lines[0]);
+			++i) {
+		free(parser->lines[i].blocks);
+		free(parser->lines[i].strings);
+	}
+	memset(parser->lines, 0, sizeof(parser->lines));
+}
+
+static struct i3bar_line *building_line(struct i3bar_parser *parser) {
+	return &parser->lines[parser->building];
+}
+
+static bool line_append(struct i3bar_line *line, const char *data,
+		size_t len) {
+	if (line->strings_len + len > line->strings_cap) {
+		size_t cap = line->strings_cap ? line->strings_cap : 256;
+		while (line->strings_len + len > cap) {
+			cap *= 2;
+		}
+		char *strings = realloc(line->strings, cap);
+		if (!strings) {
+			return false;
+		}
+		line->strings = strings;
+		line->strings_cap = cap;
+	}
+	memcpy(&line->strings[line->strings_len], data, len);
+	line->strings_len += len;
+	return true;
+}
+
+static struct i3bar_parsed_block *line_add_block(struct i3bar_line *line) {
+	if (line->len == line->cap) {
+		size_t cap = line->cap ? line->cap * 2 : 16;
+		struct i3bar_parsed_block *blocks =
+			realloc(line->blocks, cap * sizeof(struct i3bar_parsed_block));
+		if (!blocks) {
+			return NULL;
+		}
+		line->blocks = blocks;
+		line->cap = cap;
+	}
+	struct i3bar_parsed_block *block = &line->blocks[line->len++];
+	memset(block, 0, sizeof(struct i3bar_parsed_block));
+	return block;
+}
+
+// Whether the parser is directly inside a block of a status line
+static bool in_block(struct i3bar_parser *parser) {
+	return parser->depth == DEPTH_FIELD &&
+		parser->stack[DEPTH_LINE] == '[' && parser->stack[DEPTH_BLOCK] == '{';
+}
+
+static struct i3bar_value *field_value(struct i3bar_parser *parser) {
+	struct i3bar_line *line = building_line(parser);
+	if (!in_block(parser) || parser->field < 0 || !line->len) {
+		return NULL;
+	}
+	return &line->blocks[line->len - 1].fields[parser->field];
+}
+
+static void value_done(struct i3bar_parser *parser) {
+	parser->expect = parser->depth == DEPTH_STREAM ?
+		I3BAR_EXPECT_NOTHING : I3BAR_EXPECT_COMMA_OR_END;
+	if (parser->depth == DEPTH_FIELD) {
+		parser->field = -1;
+	}
+}
+
+static bool begin_container(struct i3bar_parser *parser, char c) {
+	if (parser->depth == I3BAR_PARSER_MAX_DEPTH) {
+		return false;
+	}
+	struct i3bar_line *line = building_line(parser);
+	switch (parser->depth) {
+	case DEPTH_STREAM:
+		if (c != '[') {
+			return false;
+		}
+		break;
+	case DEPTH_LINE:
+		if (c == '[') {
+			line->len = 0;
+			line->strings_len = 0;
+		}
+		break;
+	case DEPTH_BLOCK:
+		if (c == '{' && parser->stack[DEPTH_LINE] == '[' &&
+				!line_add_block(line)) {
+			return false;
+		}
+		break;
+	case DEPTH_FIELD:;
+		// Objects and arrays aren't used for any field
+		struct i3bar_value *value = field_value(parser);
+		if (value) {
+			value->type = I3BAR_VALUE_NONE;
+		}
+		break;
+	}
+	parser->stack[parser->depth++] = c;
+	parser->expect = c == '[' ?
+		I3BAR_EXPECT_VALUE_OR_END : I3BAR_EXPECT_KEY_OR_END;
+	return true;
+}
+
+static bool end_container(struct i3bar_parser *parser, char c) {
+	char open = c == ']' ? '[' : '{';
+	if (!parser->depth || parser->stack[parser->depth - 1] != open) {
+		return false;
+	}
+	--parser->depth;
+	if (parser->depth == DEPTH_LINE && c == ']') {
+		parser->building ^= 1;
+		parser->line_ready = true;
+	}
+	value_done(parser);
+	return true;
+}
+
+static void begin_string(struct i3bar_parser *parser, bool is_key) {
+	parser->token = I3BAR_TOKEN_STRING;
+	parser->token_is_key = is_key;
+	parser->token_len = 0;
+	parser->token_overflow = false;
+	parser->high_surrogate = 0;
+	struct i3bar_value *value = is_key ? NULL : field_value(parser);
+	if (value) {
+		value->type = I3BAR_VALUE_STRING;
+		value->offset = building_line(parser)->strings_len;
+	}
+}
+
+static bool string_append(struct i3bar_parser *parser, const char *data,
+		size_t len) {
+	if (parser->token_is_key) {
+		if (parser->token_len + len >= I3BAR_PARSER_TOKEN_MAX) {
+			parser->token_overflow = true;
+			return true;
+		}
+		memcpy(&parser->token_buf[parser->token_len], data, len);
+		parser->token_len += len;
+		return true;
+	}
+	if (field_value(parser)) {
+		return line_append(building_line(parser), data, len);
+	}
+	return true;
+}
+
+static bool string_codepoint(struct i3bar_parser *parser, uint32_t cp) {
+	char utf8[4];
+	size_t len;
+	if (cp < 0x80) {
+		utf8[0] = cp;
+		len = 1;
+	} else if (cp < 0x800) {
+		utf8[0] = 0xC0 | (cp >> 6);
+		utf8[1] = 0x80 | (cp & 0x3F);
+		len = 2;
+	} else if (cp < 0x10000) {
+		utf8[0] = 0xE0 | (cp >> 12);
+		utf8[1] = 0x80 | ((cp >> 6) & 0x3F);
+		utf8[2] = 0x80 | (cp & 0x3F);
+		len = 3;
+	} else {
+		utf8[0] = 0xF0 | (cp >> 18);
+		utf8[1] = 0x80 | ((cp >> 12) & 0x3F);
+		utf8[2] = 0x80 | ((cp >> 6) & 0x3F);
+		utf8[3] = 0x80 | (cp & 0x3F);
+		len = 4;
+	}
+	return string_append(parser, utf8, len);
+}
+
+// A high surrogate not followed by a low one becomes a replacement character
+static bool flush_surrogate(struct i3bar_parser *parser) {
+	if (!parser->high_surrogate) {
+		return true;
+	}
+	parser->high_surrogate = 0;
+	return string_codepoint(parser, 0xFFFD);
+}
+
+static bool string_escaped_codepoint(struct i3bar_parser *parser,
+		uint32_t cp) {
+	if (cp >= 0xD800 && cp <= 0xDBFF) {
+		if (!flush_surrogate(parser)) {
+			return false;
+		}
+		parser->high_surrogate = cp;
+		return true;
+	}
+	if (cp >= 0xDC00 && cp <= 0xDFFF) {
+		if (!parser->high_surrogate) {
+			return string_codepoint(parser, 0xFFFD);
+		}
+		cp = 0x10000 + ((parser->high_surrogate - 0xD800) << 10) +
+			(cp - 0xDC00);
+		parser->high_surrogate = 0;
+		return string_codepoint(parser, cp);
+	}
+	return flush_surrogate(parser) && string_codepoint(parser, cp);
+}
+
+static bool end_string(struct i3bar_parser *parser) {
+	if (!flush_surrogate(parser)) {
+		return false;
+	}
+	parser->token = I3BAR_TOKEN_NONE;
+	if (parser->token_is_key) {
+		parser->field = -1;
+		if (in_block(parser) && !parser->token_overflow) {
+			parser->token_buf[parser->token_len] = '\0';
+			for (int i = 0; i < I3BAR_FIELD_COUNT; ++i) {
+				if (strcmp(parser->token_buf, field_names[i]) == 0) {
+					parser->field = i;
+					break;
+				}
+			}
+		}
+		parser->expect = I3BAR_EXPECT_COLON;
+		return true;
+	}
+	if (parser->depth == DEPTH_STREAM) {
+		return false;
+	}
+	if (field_value(parser) && !line_append(building_line(parser), "", 1)) {
+		return false;
+	}
+	value_done(parser);
+	return true;
+}
+
+static const char *skip_digits(const char *text) {
+	while (isdigit((unsigned char)*text)) {
+		++text;
+	}
+	return text;
+}
+
+/**
+ * Whether the text is a number as JSON has them: an optional minus, an integer
+ * part without leading zeroes, then an optional fraction and exponent.
+ * strtod would also take things like "-nan", "-inf" or "-0x1f".
+ */
+static bool is_json_number(const char *text) {
+	if (*text == '-') {
+		++text;
+	}
+	if (*text == '0') {
+		++text;
+	} else if (isdigit((unsigned char)*text)) {
+		text = skip_digits(text);
+	} else {
+		return false;
+	}
+	if (*text == '.') {
+		++text;
+		if (!isdigit((unsigned char)*text)) {
+			return false;
+		}
+		text = skip_digits(text);
+	}
+	if (*text == 'e' || *text == 'E') {
+		++text;
+		if (*text == '+' || *text == '-') {
+			++text;
+		}
+		if (!isdigit((unsigned char)*text)) {
+			return false;
+		}
+		text = skip_digits(text);
+	}
+	return *text == '\0';
+}
+
+static bool end_scalar(struct i3bar_parser *parser) {
+	parser->token = I3BAR_TOKEN_NONE;
+	if (parser->token_overflow || parser->depth == DEPTH_STREAM) {
+		return false;
+	}
+	parser->token_buf[parser->token_len] = '\0';
+	const char *text = parser->token_buf;
+	enum i3bar_value_type type;
+	if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0) {
+		type = I3BAR_VALUE_BOOLEAN;
+	} else if (strcmp(text, "null") == 0) {
+		type = I3BAR_VALUE_NONE;
+	} else if (is_json_number(text)) {
+		type = I3BAR_VALUE_NUMBER;
+	} else {
+		return false;
+	}
+	struct i3bar_value *value = field_value(parser);
+	if (value) {
+		struct i3bar_line *line = building_line(parser);
+		value->type = type;
+		value->offset = line->strings_len;
+		if (!line_append(line, text, parser->token_len + 1)) {
+			return false;
+		}
+	}
+	value_done(parser);
+	return true;
+}
+
+static int hex_value(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+static bool is_scalar_char(char c) {
+	return isalnum((unsigned char)c) || c == '-' || c == '+' || c == '.';
+}
+
+static bool feed_structure(struct i3bar_parser *parser, char c) {
+	enum i3bar_parser_expect expect = parser->expect;
+	bool want_value = expect == I3BAR_EXPECT_VALUE ||
+		expect == I3BAR_EXPECT_VALUE_OR_END;
+	switch (c) {
+	case ' ':
+	case '\t':
+	case '\n':
+	case '\r':
+		return true;
+	case '"':
+		if (expect == I3BAR_EXPECT_KEY || expect == I3BAR_EXPECT_KEY_OR_END) {
+			begin_string(parser, true);
+			return true;
+		}
+		if (!want_value || parser->depth == DEPTH_STREAM) {
+			return false;
+		}
+		begin_string(parser, false);
+		return true;
+	case ':':
+		if (expect != I3BAR_EXPECT_COLON) {
+			return false;
+		}
+		parser->expect = I3BAR_EXPECT_VALUE;
+		return true;
+	case ',':
+		if (expect != I3BAR_EXPECT_COMMA_OR_END) {
+			return false;
+		}
+		parser->expect = parser->stack[parser->depth - 1] == '[' ?
+			I3BAR_EXPECT_VALUE : I3BAR_EXPECT_KEY;
+		return true;
+	case ']':
+		if (expect != I3BAR_EXPECT_COMMA_OR_END &&
+				expect != I3BAR_EXPECT_VALUE_OR_END) {
+			return false;
+		}
+		return end_container(parser, c);
+	case '}':
+		if (expect != I3BAR_EXPECT_COMMA_OR_END &&
+				expect != I3BAR_EXPECT_KEY_OR_END) {
+			return false;
+		}
+		return end_container(parser, c);
+	case '[':
+	case '{':
+		return want_value && begin_container(parser, c);
+	}
+	if (!want_value || !is_scalar_char(c)) {
+		return false;
+	}
+	parser->token = I3BAR_TOKEN_SCALAR;
+	parser->token_buf[0] = c;
+	parser->token_len = 1;
+	parser->token_overflow = false;
+	return true;
+}
+
+bool i3bar_parser_feed(struct i3bar_parser *parser, const char *data,
+		size_t len) {
+	for (size_t i = 0; i < len; ++i) {
+		char c = data[i];
+		switch (parser->token) {
+		case I3BAR_TOKEN_STRING:;
+			// Copy everything up to the next quote or escape at once
+			size_t run = i;
+			while (run < len && data[run] != '"' && data[run] != '\\') {
+				++run;
+			}
+			if (run > i) {
+				if (!flush_surrogate(parser) ||
+						!string_append(parser, &data[i], run - i)) {
+					return false;
+				}
+				i = run - 1;
+			} else if (c == '"') {
+				if (!end_string(parser)) {
+					return false;
+				}
+			} else {
+				parser->token = I3BAR_TOKEN_ESCAPE;
+			}
+			continue;
+		case I3BAR_TOKEN_ESCAPE:;
+			char unescaped;
+			switch (c) {
+			case '"':
+			case '\\':
+			case '/':
+				unescaped = c;
+				break;
+			case 'b':
+				unescaped = '\b';
+				break;
+			case 'f':
+				unescaped = '\f';
+				break;
+			case 'n':
+				unescaped = '\n';
+				break;
+			case 'r':
+				unescaped = '\r';
+				break;
+			case 't':
+				unescaped = '\t';
+				break;
+			case 'u':
+				parser->token = I3BAR_TOKEN_UNICODE;
+				parser->codepoint = 0;
+				parser->codepoint_digits = 0;
+				continue;
+			default:
+				return false;
+			}
+			parser->token = I3BAR_TOKEN_STRING;
+			if (!flush_surrogate(parser) ||
+					!string_append(parser, &unescaped, 1)) {
+				return false;
+			}
+			continue;
+		case I3BAR_TOKEN_UNICODE:;
+			int digit = hex_value(c);
+			if (digit < 0) {
+				return false;
+			}
+			parser->codepoint = parser->codepoint * 16 + digit;
+			if (++parser->codepoint_digits == 4) {
+				parser->token = I3BAR_TOKEN_STRING;
+				if (!string_escaped_codepoint(parser, parser->codepoint)) {
+					return false;
+				}
+			}
+			continue;
+		case I3BAR_TOKEN_SCALAR:
+			if (is_scalar_char(c)) {
+				if (parser->token_len + 1 >= I3BAR_PARSER_TOKEN_MAX) {
+					parser->token_overflow = true;
+				} else {
+					parser->token_buf[parser->token_len++] = c;
+				}
+				continue;
+			}
+			if (!end_scalar(parser)) {
+				return false;
+			}
+			break;
+		case I3BAR_TOKEN_NONE:
+			break;
+		}
+		if (!feed_structure(parser, c)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct i3bar_line *i3bar_parser_take_line(struct i3bar_parser *parser) {
+	if (!parser->line_ready) {
+		return NULL;
+	}
+	parser->line_ready = false;
+	return &parser->lines[parser->building ^ 1];
+}
+
+const char *i3bar_value_string(struct i3bar_line *line,
+		struct i3bar_value *value) {
+	if (value->type == I3BAR_VALUE_NONE) {
+		return NULL;
+	}
+	return &line->strings[value->offset];
+}
+
+int i3bar_value_int(struct i3bar_line *line, struct i3bar_value *value) {
+	const char *text = i3bar_value_string(line, value);
+	switch (value->type) {
+	case I3BAR_VALUE_NONE:
+		return 0;
+	case I3BAR_VALUE_BOOLEAN:
+		return text[0] == 't';
+	case I3BAR_VALUE_NUMBER:;
+		double number = strtod(text, NULL);
+		if (isnan(number)) {
+			return 0;
+		} else if (number > INT_MAX) {
+			return INT_MAX;
+		} else if (number < INT_MIN) {
+			return INT_MIN;
+		}
+		return number;
+	case I3BAR_VALUE_STRING:
+		return strtol(text, NULL, 10);
+	}
+	return 0;
+}
+
+bool i3bar_value_is_int(struct i3bar_line *line, struct i3bar_value *value) {
+	return value->type == I3BAR_VALUE_NUMBER &&
+		!strpbrk(i3bar_value_string(line, value), ".eE");
+}
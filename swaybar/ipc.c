@@ -178,6 +178,7 @@ static bool ipc_parse_config(
 	json_object *strip_workspace_numbers, *strip_workspace_name;
 	json_object *binding_mode_indicator, *verbose, *colors, *sep_symbol;
 	json_object *outputs, *bindings, *status_padding, *status_edge_padding;
+	json_object *status_min_interval;
 	json_object_object_get_ex(bar_config, "mode", &mode);
 	json_object_object_get_ex(bar_config, "hidden_state", &hidden_state);
 	json_object_object_get_ex(bar_config, "position", &position);
@@ -199,6 +200,8 @@ static bool ipc_parse_config(
 	json_object_object_get_ex(bar_config, "status_padding", &status_padding);
 	json_object_object_get_ex(bar_config, "status_edge_padding",
 			&status_edge_padding);
+	json_object_object_get_ex(bar_config, "status_min_interval",
+			&status_min_interval);
 	if (status_command) {
 		free(config->status_command);
 		config->status_command = strdup(json_object_get_string(status_command));
@@ -238,6 +241,9 @@ static bool ipc_parse_config(
 	if (status_edge_padding) {
 		config->status_edge_padding = json_object_get_int(status_edge_padding);
 	}
+	if (status_min_interval) {
+		config->status_min_interval = json_object_get_int(status_min_interval);
+	}
 	if (gaps) {
 		json_object *top = json_object_object_get(gaps, "top");
 		if (top) {
@@ -352,6 +358,115 @@ static bool ipc_parse_config(
 	return true;
 }
 
+static void workspace_set_label(struct swaybar *bar,
+		struct swaybar_workspace *ws) {
+	free(ws->label);
+	ws->label = strdup(ws->name);
+	// ws->num will be -1 if workspace name doesn't begin with int.
+	if (ws->num != -1) {
+		size_t len_offset = snprintf(NULL, 0, "%d", ws->num);
+		if (bar->config->strip_workspace_name) {
+			free(ws->label);
+			ws->label = malloc(len_offset + 1);
+			snprintf(ws->label, len_offset + 1, "%d", ws->num);
+		} else if (bar->config->strip_workspace_numbers) {
+			len_offset += ws->label[len_offset] == ':';
+			if (ws->name[len_offset] != '\0') {
+				free(ws->label);
+				// Strip number prefix [1-?:] using len_offset.
+				ws->label = strdup(ws->name + len_offset);
+			}
+		}
+	}
+}
+
+static struct swaybar_output *find_output(struct swaybar *bar,
+		const char *name) {
+	if (!name) {
+		return NULL;
+	}
+	struct swaybar_output *output;
+	wl_list_for_each(output, &bar->outputs, link) {
+		if (strcmp(name, output->name) == 0) {
+			return output;
+		}
+	}
+	return NULL;
+}
+
+static struct swaybar_workspace *find_workspace(struct swaybar *bar, int id,
+		struct swaybar_output **ws_output) {
+	struct swaybar_output *output;
+	wl_list_for_each(output, &bar->outputs, link) {
+		struct swaybar_workspace *ws;
+		wl_list_for_each(ws, &output->workspaces, link) {
+			if (ws->id == id) {
+				*ws_output = output;
+				return ws;
+			}
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Compares workspaces the way sway sorts them on their output: numbered
+ * workspaces by number, then everything else.
+ */
+static int workspace_cmp(struct swaybar_workspace *a,
+		struct swaybar_workspace *b) {
+	if (a->num != -1 && b->num != -1) {
+		return (a->num < b->num) ? -1 : (a->num > b->num);
+	} else if (a->num != -1) {
+		return -1;
+	} else if (b->num != -1) {
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Moves the workspace to where sway's stable sort puts it, assuming the
+ * other workspaces of the output are in order.
+ */
+static void workspace_sort(struct swaybar_output *output,
+		struct swaybar_workspace *ws) {
+	struct wl_list *pos = ws->link.prev;
+	while (pos != &output->workspaces) {
+		struct swaybar_workspace *prev = wl_container_of(pos, prev, link);
+		if (workspace_cmp(prev, ws) <= 0) {
+			break;
+		}
+		pos = pos->prev;
+	}
+	if (pos == ws->link.prev) {
+		pos = ws->link.next;
+		while (pos != &output->workspaces) {
+			struct swaybar_workspace *next = wl_container_of(pos, next, link);
+			if (workspace_cmp(ws, next) <= 0) {
+				break;
+			}
+			pos = pos->next;
+		}
+		pos = pos->prev;
+	}
+	if (pos != &ws->link) {
+		wl_list_remove(&ws->link);
+		wl_list_insert(pos, &ws->link);
+	}
+}
+
+static void update_visible_by_urgency(struct swaybar *bar) {
+	bar->visible_by_urgency = false;
+	struct swaybar_output *output;
+	wl_list_for_each(output, &bar->outputs, link) {
+		struct swaybar_workspace *ws;
+		wl_list_for_each(ws, &output->workspaces, link) {
+			bar->visible_by_urgency |= ws->urgent;
+		}
+	}
+}
+
 bool ipc_get_workspaces(struct swaybar *bar) {
 	struct swaybar_output *output;
 	wl_list_for_each(output, &bar->outputs, link) {
@@ -370,10 +485,11 @@ bool ipc_get_workspaces(struct swaybar *bar) {
 	bar->visible_by_urgency = false;
 	size_t length = json_object_array_length(results);
 	json_object *ws_json;
-	json_object *num, *name, *visible, *focused, *out, *urgent;
+	json_object *id, *num, *name, *visible, *focused, *out, *urgent;
 	for (size_t i = 0; i < length; ++i) {
 		ws_json = json_object_array_get_idx(results, i);
 
+		json_object_object_get_ex(ws_json, "id", &id);
 		json_object_object_get_ex(ws_json, "num", &num);
 		json_object_object_get_ex(ws_json, "name", &name);
 		json_object_object_get_ex(ws_json, "visible", &visible);
@@ -381,48 +497,142 @@ bool ipc_get_workspaces(struct swaybar *bar) {
 		json_object_object_get_ex(ws_json, "output", &out);
 		json_object_object_get_ex(ws_json, "urgent", &urgent);
 
-		wl_list_for_each(output, &bar->outputs, link) {
-			const char *ws_output = json_object_get_string(out);
-			if (strcmp(ws_output, output->name) == 0) {
-				struct swaybar_workspace *ws =
-					calloc(1, sizeof(struct swaybar_workspace));
-				ws->num = json_object_get_int(num);
-				ws->name = strdup(json_object_get_string(name));
-				ws->label = strdup(ws->name);
-				// ws->num will be -1 if workspace name doesn't begin with int.
-				if (ws->num != -1) {
-					size_t len_offset = snprintf(NULL, 0, "%d", ws->num);
-					if (bar->config->strip_workspace_name) {
-						free(ws->label);
-						ws->label = malloc(len_offset + 1);
-						snprintf(ws->label, len_offset + 1, "%d", ws->num);
-					} else if (bar->config->strip_workspace_numbers) {
-						len_offset += ws->label[len_offset] == ':';
-						if (ws->name[len_offset] != '\0') {
-							free(ws->label);
-							// Strip number prefix [1-?:] using len_offset.
-							ws->label = strdup(ws->name + len_offset);
-						}
-					}
-				}
-				ws->visible = json_object_get_boolean(visible);
-				ws->focused = json_object_get_boolean(focused);
-				if (ws->focused) {
-					output->focused = true;
-				}
-				ws->urgent = json_object_get_boolean(urgent);
-				if (ws->urgent) {
-					bar->visible_by_urgency = true;
-				}
-				wl_list_insert(output->workspaces.prev, &ws->link);
-			}
+		output = find_output(bar, json_object_get_string(out));
+		if (!output) {
+			continue;
+		}
+		struct swaybar_workspace *ws =
+			calloc(1, sizeof(struct swaybar_workspace));
+		ws->id = json_object_get_int(id);
+		ws->num = json_object_get_int(num);
+		ws->name = strdup(json_object_get_string(name));
+		workspace_set_label(bar, ws);
+		ws->visible = json_object_get_boolean(visible);
+		ws->focused = json_object_get_boolean(focused);
+		if (ws->focused) {
+			output->focused = true;
+		}
+		ws->urgent = json_object_get_boolean(urgent);
+		if (ws->urgent) {
+			bar->visible_by_urgency = true;
 		}
+		wl_list_insert(output->workspaces.prev, &ws->link);
 	}
 	json_object_put(results);
 	free(res);
 	return determine_bar_visibility(bar, false);
 }
 
+/**
+ * Applies a workspace event to the workspaces, using the workspace it
+ * carries. Returns false if the event can't be applied on its own, in which
+ * case the workspaces need to be fetched again.
+ */
+static bool apply_workspace_event(struct swaybar *bar, json_object *event) {
+	json_object *json_change, *current;
+	if (!json_object_object_get_ex(event, "change", &json_change) ||
+			!json_object_object_get_ex(event, "current", &current) ||
+			!current) {
+		return false;
+	}
+	const char *change = json_object_get_string(json_change);
+
+	json_object *id, *num, *name, *out, *urgent;
+	if (!json_object_object_get_ex(current, "id", &id) ||
+			!json_object_object_get_ex(current, "num", &num) ||
+			!json_object_object_get_ex(current, "name", &name) ||
+			!json_object_object_get_ex(current, "output", &out) ||
+			!json_object_object_get_ex(current, "urgent", &urgent) ||
+			!name) {
+		return false;
+	}
+	struct swaybar_output *output = find_output(bar,
+			json_object_get_string(out));
+	struct swaybar_output *ws_output = NULL;
+	struct swaybar_workspace *ws =
+		find_workspace(bar, json_object_get_int(id), &ws_output);
+	if (ws && ws_output != output) {
+		return false;
+	}
+
+	if (strcmp(change, "init") == 0) {
+		if (ws) {
+			return false;
+		}
+		if (!output) {
+			return true;
+		}
+		ws = calloc(1, sizeof(struct swaybar_workspace));
+		ws->id = json_object_get_int(id);
+		ws->num = json_object_get_int(num);
+		ws->name = strdup(json_object_get_string(name));
+		workspace_set_label(bar, ws);
+		ws->urgent = json_object_get_boolean(urgent);
+		// The first workspace of an output is shown without being focused
+		ws->visible = wl_list_empty(&output->workspaces);
+		wl_list_insert(output->workspaces.prev, &ws->link);
+		workspace_sort(output, ws);
+	} else if (strcmp(change, "empty") == 0) {
+		if (!ws) {
+			return !output;
+		}
+		if (ws->focused) {
+			output->focused = false;
+		}
+		wl_list_remove(&ws->link);
+		free(ws->name);
+		free(ws->label);
+		free(ws);
+	} else if (strcmp(change, "focus") == 0) {
+		if (!ws && output) {
+			return false;
+		}
+		struct swaybar_output *other;
+		wl_list_for_each(other, &bar->outputs, link) {
+			other->focused = false;
+			struct swaybar_workspace *other_ws;
+			wl_list_for_each(other_ws, &other->workspaces, link) {
+				other_ws->focused = false;
+				if (other == output) {
+					other_ws->visible = false;
+				}
+			}
+		}
+		if (ws) {
+			ws->focused = ws->visible = true;
+			output->focused = true;
+		}
+	} else if (strcmp(change, "rename") == 0) {
+		if (!ws) {
+			return !output;
+		}
+		free(ws->name);
+		ws->num = json_object_get_int(num);
+		ws->name = strdup(json_object_get_string(name));
+		workspace_set_label(bar, ws);
+		workspace_sort(output, ws);
+	} else if (strcmp(change, "urgent") == 0) {
+		if (!ws) {
+			return !output;
+		}
+		ws->urgent = json_object_get_boolean(urgent);
+	} else {
+		// Moves can change which workspaces are visible on both outputs, and
+		// reloads can change anything
+		return false;
+	}
+	update_visible_by_urgency(bar);
+	return true;
+}
+
+static bool handle_workspace_event(struct swaybar *bar, json_object *event) {
+	if (!apply_workspace_event(bar, event)) {
+		sway_log(SWAY_DEBUG, "Fetching workspaces after workspace event");
+		return ipc_get_workspaces(bar);
+	}
+	return determine_bar_visibility(bar, false);
+}
+
 static void ipc_get_outputs(struct swaybar *bar) {
 	uint32_t len = 0;
 	char *res = ipc_single_command(bar->ipc_socketfd,
@@ -570,7 +780,7 @@ bool handle_ipc_readable(struct swaybar *bar) {
 	bool bar_is_dirty = true;
 	switch (resp->type) {
 	case IPC_EVENT_WORKSPACE:
-		bar_is_dirty = ipc_get_workspaces(bar);
+		bar_is_dirty = handle_workspace_event(bar, result);
 		break;
 	case IPC_EVENT_MODE: {
 		json_object *json_change, *json_pango_markup;
@@ -2,6 +2,8 @@
 #include <assert.h>
 #include <linux/input-event-codes.h>
 #include <limits.h>
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
@@ -23,8 +25,207 @@ static const int WS_HORIZONTAL_PADDING = 5;
 static const double WS_VERTICAL_PADDING = 1.5;
 static const double BORDER_WIDTH = 1;
 
+/**
+ * A piece of the bar (workspace button, status block, ...) rasterised on its
+ * own, so that it only needs to be drawn again when what it shows changes.
+ */
+struct render_element {
+	char *key; // describes everything drawn, NULL to redraw every frame
+	cairo_surface_t *image; // NULL if the element drew nothing
+	int x, width; // in buffer coordinates
+	int offset; // of x from where the element was drawn
+	double advance; // how far drawing the element moved the pen
+	uint32_t ideal_height;
+	int hotspot_width;
+	bool redrawn; // rather than taken from the last frame
+};
+
+struct render_context {
+	struct swaybar_output *output;
+	cairo_font_options_t *font_options;
+	uint32_t background;
+	list_t *old_elements; // from the last frame, not yet reused
+	list_t *elements;
+	cairo_region_t *damage;
+};
+
+typedef uint32_t (*render_element_func)(cairo_t *cairo,
+		struct swaybar_output *output, double *x, void *data);
+
+static void render_element_destroy(struct render_element *element) {
+	if (!element) {
+		return;
+	}
+	free(element->key);
+	if (element->image) {
+		cairo_surface_destroy(element->image);
+	}
+	free(element);
+}
+
+static void damage_element(struct render_context *ctx,
+		struct render_element *element) {
+	if (!element->image) {
+		return;
+	}
+	cairo_rectangle_int_t rect = {
+		.x = element->x,
+		.width = element->width,
+		.height = cairo_image_surface_get_height(element->image),
+	};
+	cairo_region_union_rectangle(ctx->damage, &rect);
+}
+
+static bool element_images_equal(struct render_element *a,
+		struct render_element *b) {
+	if (a->x != b->x || a->width != b->width) {
+		return false;
+	}
+	if (!a->image || !b->image) {
+		return a->image == b->image;
+	}
+	cairo_surface_flush(a->image);
+	cairo_surface_flush(b->image);
+	int stride = cairo_image_surface_get_stride(a->image);
+	int height = cairo_image_surface_get_height(a->image);
+	return stride == cairo_image_surface_get_stride(b->image) &&
+		height == cairo_image_surface_get_height(b->image) &&
+		memcmp(cairo_image_surface_get_data(a->image),
+			cairo_image_surface_get_data(b->image), stride * height) == 0;
+}
+
+static void draw_element(struct render_context *ctx,
+		struct render_element *element, double *x,
+		render_element_func func, void *data) {
+	struct swaybar_output *output = ctx->output;
+	cairo_surface_t *recorder = cairo_recording_surface_create(
+			CAIRO_CONTENT_COLOR_ALPHA, NULL);
+	cairo_t *cairo = cairo_create(recorder);
+	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
+	cairo_set_font_options(cairo, ctx->font_options);
+	// Draw over the bar background, so that text is antialiased against it
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_u32(cairo, ctx->background);
+	cairo_paint(cairo);
+
+	double start = *x;
+	element->ideal_height = func(cairo, output, x, data);
+	element->advance = *x - start;
+	element->x = floor(fmin(start, *x));
+	element->width = (int)ceil(fmax(start, *x)) - element->x;
+	element->offset = element->x - (int)floor(start);
+	element->redrawn = true;
+
+	int height = output->height * output->scale;
+	if (element->width > 0 && height > 0) {
+		element->image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+				element->width, height);
+		cairo_t *image = cairo_create(element->image);
+		cairo_set_source_surface(image, recorder, -element->x, 0);
+		cairo_paint(image);
+		cairo_destroy(image);
+	}
+	cairo_destroy(cairo);
+	cairo_surface_destroy(recorder);
+}
+
+/**
+ * Adds an element to the frame at *x and moves x past it. The element is
+ * reused from the last frame if one with the same key was drawn, otherwise
+ * func is called to draw it. Takes ownership of key.
+ */
+static struct render_element *render_element(struct render_context *ctx,
+		char *key, double *x, render_element_func func, void *data) {
+	struct render_element *element = NULL;
+	for (int i = 0; i < ctx->old_elements->length; ++i) {
+		struct render_element *old = ctx->old_elements->items[i];
+		if (key ? old->key && strcmp(old->key, key) == 0 : !old->key) {
+			element = old;
+			list_del(ctx->old_elements, i);
+			break;
+		}
+	}
+
+	if (element && key) {
+		free(key);
+		int new_x = (int)floor(*x) + element->offset;
+		if (new_x != element->x) {
+			damage_element(ctx, element);
+			element->x = new_x;
+			damage_element(ctx, element);
+		}
+		*x += element->advance;
+		element->redrawn = false;
+		list_add(ctx->elements, element);
+		return element;
+	}
+
+	struct render_element *drawn = calloc(1, sizeof(struct render_element));
+	drawn->key = key;
+	drawn->hotspot_width = -1;
+	draw_element(ctx, drawn, x, func, data);
+	if (element && element_images_equal(element, drawn)) {
+		// Redrawn every frame, but didn't change
+		render_element_destroy(element);
+	} else {
+		if (element) {
+			damage_element(ctx, element);
+			render_element_destroy(element);
+		}
+		damage_element(ctx, drawn);
+	}
+	list_add(ctx->elements, drawn);
+	return drawn;
+}
+
+/**
+ * Element keys are built from everything the element is drawn from. Strings
+ * are length-prefixed so that they can't run into the fields around them.
+ */
+static void key_add_string(FILE *key, const char *str) {
+	if (str) {
+		fprintf(key, "%zu:%s;", strlen(str), str);
+	} else {
+		fprintf(key, "-;");
+	}
+}
+
+static FILE *key_open(char **key, size_t *size,
+		struct swaybar_output *output, const char *type) {
+	FILE *f = open_memstream(key, size);
+	if (!f) {
+		return NULL;
+	}
+	fprintf(f, "%s;%d;", type, output->scale);
+	key_add_string(f, output->bar->config->font);
+	return f;
+}
+
+static char *key_close(FILE *f, char *key) {
+	if (!f || fclose(f) != 0) {
+		// Can't be cached, so draw it every time
+		free(key);
+		return NULL;
+	}
+	return key;
+}
+
+void free_render_cache(struct swaybar_output *output) {
+	if (output->canvas) {
+		cairo_surface_destroy(output->canvas);
+		output->canvas = NULL;
+	}
+	if (output->elements) {
+		for (int i = 0; i < output->elements->length; ++i) {
+			render_element_destroy(output->elements->items[i]);
+		}
+		list_free(output->elements);
+		output->elements = NULL;
+	}
+}
+
 static uint32_t render_status_line_error(cairo_t *cairo,
-		struct swaybar_output *output, double *x) {
+		struct swaybar_output *output, double *x, void *data) {
 	const char *error = output->bar->status->text;
 	if (!error) {
 		return 0;
@@ -59,7 +260,7 @@ static uint32_t render_status_line_error(cairo_t *cairo,
 }
 
 static uint32_t render_status_line_text(cairo_t *cairo,
-		struct swaybar_output *output, double *x) {
+		struct swaybar_output *output, double *x, void *data) {
 	const char *text = output->bar->status->text;
 	if (!text) {
 		return 0;
@@ -142,9 +343,17 @@ static void i3bar_block_unref_callback(void *data) {
 	i3bar_block_unref(data);
 }
 
+struct status_block_data {
+	struct i3bar_block *block;
+	bool edge;
+	int hotspot_width;
+};
+
 static uint32_t render_status_block(cairo_t *cairo,
-		struct swaybar_output *output, struct i3bar_block *block, double *x,
-		bool edge) {
+		struct swaybar_output *output, double *x, void *_data) {
+	struct status_block_data *data = _data;
+	struct i3bar_block *block = data->block;
+	bool edge = data->edge;
 	if (!block->full_text || !*block->full_text) {
 		return 0;
 	}
@@ -209,18 +418,7 @@ static uint32_t render_status_block(cairo_t *cairo,
 	}
 
 	uint32_t height = output->height * output->scale;
-	if (output->bar->status->click_events) {
-		struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
-		hotspot->x = *x;
-		hotspot->y = 0;
-		hotspot->width = width;
-		hotspot->height = height;
-		hotspot->callback = block_hotspot_callback;
-		hotspot->destroy = i3bar_block_unref_callback;
-		hotspot->data = block;
-		block->ref_count++;
-		wl_list_insert(&output->hotspots, &hotspot->link);
-	}
+	data->hotspot_width = width;
 
 	double x_pos = *x;
 	double y_pos = ws_vertical_padding;
@@ -294,29 +492,111 @@ static uint32_t render_status_block(cairo_t *cairo,
 	return output->height;
 }
 
-static uint32_t render_status_line_i3bar(cairo_t *cairo,
-		struct swaybar_output *output, double *x) {
+static char *status_block_key(struct swaybar_output *output,
+		struct i3bar_block *block, bool edge) {
+	struct swaybar_config *config = output->bar->config;
+	char *key = NULL;
+	size_t size;
+	FILE *f = key_open(&key, &size, output, "block");
+	if (!f) {
+		return NULL;
+	}
+	key_add_string(f, block->full_text);
+	key_add_string(f, block->min_width_str);
+	key_add_string(f, block->align);
+	fprintf(f, "%d;%d;%d;%d;%d;%d;", block->min_width, block->markup,
+			block->urgent, block->separator, block->separator_block_width,
+			edge);
+	if (block->color) {
+		fprintf(f, "%08x;", *block->color);
+	} else {
+		fprintf(f, "-;");
+	}
+	fprintf(f, "%08x;%08x;%d;%d;%d;%d;", block->background, block->border,
+			block->border_top, block->border_bottom, block->border_left,
+			block->border_right);
+	key_add_string(f, config->sep_symbol);
+	fprintf(f, "%d;%d;%08x;%08x;%08x;%08x;%08x;%08x;",
+			config->status_padding, config->status_edge_padding,
+			config->colors.statusline,
+			config->colors.urgent_workspace.background,
+			config->colors.urgent_workspace.border,
+			config->colors.urgent_workspace.text,
+			output->focused ? config->colors.focused_separator :
+				config->colors.separator, output->bar->status->click_events);
+	return key_close(f, key);
+}
+
+static uint32_t render_status_line_i3bar(struct render_context *ctx,
+		double *x) {
+	struct swaybar_output *output = ctx->output;
 	uint32_t max_height = 0;
 	bool edge = *x == output->width * output->scale;
 	struct i3bar_block *block;
 	wl_list_for_each(block, &output->bar->status->blocks, link) {
-		uint32_t h = render_status_block(cairo, output, block, x, edge);
+		struct status_block_data data = {
+			.block = block,
+			.edge = edge,
+		};
+		struct render_element *element = render_element(ctx,
+				status_block_key(output, block, edge), x,
+				render_status_block, &data);
+		if (element->redrawn) {
+			element->hotspot_width = data.hotspot_width;
+		}
+		uint32_t h = element->ideal_height;
 		max_height = h > max_height ? h : max_height;
 		edge = false;
+
+		if (output->bar->status->click_events && element->image) {
+			struct swaybar_hotspot *hotspot =
+				calloc(1, sizeof(struct swaybar_hotspot));
+			hotspot->x = element->x;
+			hotspot->y = 0;
+			hotspot->width = element->hotspot_width;
+			hotspot->height = output->height * output->scale;
+			hotspot->callback = block_hotspot_callback;
+			hotspot->destroy = i3bar_block_unref_callback;
+			hotspot->data = block;
+			block->ref_count++;
+			wl_list_insert(&output->hotspots, &hotspot->link);
+		}
 	}
 	return max_height;
 }
 
-static uint32_t render_status_line(cairo_t *cairo,
-		struct swaybar_output *output, double *x) {
+static uint32_t render_status_line(struct render_context *ctx, double *x) {
+	struct swaybar_output *output = ctx->output;
+	struct swaybar_config *config = output->bar->config;
 	struct status_line *status = output->bar->status;
+	char *key = NULL;
+	size_t size;
+	FILE *f;
+	struct render_element *element;
 	switch (status->protocol) {
 	case PROTOCOL_ERROR:
-		return render_status_line_error(cairo, output, x);
+		f = key_open(&key, &size, output, "error");
+		if (f) {
+			key_add_string(f, status->text);
+			fprintf(f, "%d;", config->status_padding);
+		}
+		element = render_element(ctx, key_close(f, key), x,
+				render_status_line_error, NULL);
+		return element->ideal_height;
 	case PROTOCOL_TEXT:
-		return render_status_line_text(cairo, output, x);
+		f = key_open(&key, &size, output, "text");
+		if (f) {
+			key_add_string(f, status->text);
+			fprintf(f, "%d;%d;%08x;", config->pango_markup,
+					config->status_padding, output->focused ?
+					config->colors.focused_statusline :
+					config->colors.statusline);
+		}
+		element = render_element(ctx, key_close(f, key), x,
+				render_status_line_text, NULL);
+		return element->ideal_height;
 	case PROTOCOL_I3BAR:
-		return render_status_line_i3bar(cairo, output, x);
+		return render_status_line_i3bar(ctx, x);
 	case PROTOCOL_UNDEF:
 		return 0;
 	}
@@ -324,7 +604,7 @@ static uint32_t render_status_line(cairo_t *cairo,
 }
 
 static uint32_t render_binding_mode_indicator(cairo_t *cairo,
-		struct swaybar_output *output, double x) {
+		struct swaybar_output *output, double *x, void *data) {
 	const char *mode = output->bar->mode;
 	if (!mode) {
 		return 0;
@@ -351,24 +631,25 @@ static uint32_t render_binding_mode_indicator(cairo_t *cairo,
 
 	uint32_t height = output->height * output->scale;
 	cairo_set_source_u32(cairo, config->colors.binding_mode.background);
-	cairo_rectangle(cairo, x, 0, width, height);
+	cairo_rectangle(cairo, *x, 0, width, height);
 	cairo_fill(cairo);
 
 	cairo_set_source_u32(cairo, config->colors.binding_mode.border);
-	cairo_rectangle(cairo, x, 0, width, border_width);
+	cairo_rectangle(cairo, *x, 0, width, border_width);
 	cairo_fill(cairo);
-	cairo_rectangle(cairo, x, 0, border_width, height);
+	cairo_rectangle(cairo, *x, 0, border_width, height);
 	cairo_fill(cairo);
-	cairo_rectangle(cairo, x + width - border_width, 0, border_width, height);
+	cairo_rectangle(cairo, *x + width - border_width, 0, border_width, height);
 	cairo_fill(cairo);
-	cairo_rectangle(cairo, x, height - border_width, width, border_width);
+	cairo_rectangle(cairo, *x, height - border_width, width, border_width);
 	cairo_fill(cairo);
 
 	double text_y = height / 2.0 - text_height / 2.0;
 	cairo_set_source_u32(cairo, config->colors.binding_mode.text);
-	cairo_move_to(cairo, x + width / 2 - text_width / 2, (int)floor(text_y));
+	cairo_move_to(cairo, *x + width / 2 - text_width / 2, (int)floor(text_y));
 	pango_printf(cairo, config->font, output->scale,
 			output->bar->mode_pango_markup, "%s", mode);
+	*x += width;
 	return output->height;
 }
 
@@ -382,20 +663,23 @@ static enum hotspot_event_handling workspace_hotspot_callback(
 	return HOTSPOT_IGNORE;
 }
 
-static uint32_t render_workspace_button(cairo_t *cairo,
-		struct swaybar_output *output,
-		struct swaybar_workspace *ws, double *x) {
-	struct swaybar_config *config = output->bar->config;
-	struct box_colors box_colors;
+static struct box_colors workspace_button_colors(
+		struct swaybar_config *config, struct swaybar_workspace *ws) {
 	if (ws->urgent) {
-		box_colors = config->colors.urgent_workspace;
+		return config->colors.urgent_workspace;
 	} else if (ws->focused) {
-		box_colors = config->colors.focused_workspace;
+		return config->colors.focused_workspace;
 	} else if (ws->visible) {
-		box_colors = config->colors.active_workspace;
-	} else {
-		box_colors = config->colors.inactive_workspace;
+		return config->colors.active_workspace;
 	}
+	return config->colors.inactive_workspace;
+}
+
+static uint32_t render_workspace_button(cairo_t *cairo,
+		struct swaybar_output *output, double *x, void *data) {
+	struct swaybar_workspace *ws = data;
+	struct swaybar_config *config = output->bar->config;
+	struct box_colors box_colors = workspace_button_colors(config, ws);
 
 	uint32_t height = output->height * output->scale;
 
@@ -437,33 +721,86 @@ static uint32_t render_workspace_button(cairo_t *cairo,
 	pango_printf(cairo, config->font, output->scale, config->pango_markup,
 			"%s", ws->label);
 
-	struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
-	hotspot->x = *x;
-	hotspot->y = 0;
-	hotspot->width = width;
-	hotspot->height = height;
-	hotspot->callback = workspace_hotspot_callback;
-	hotspot->destroy = free;
-	hotspot->data = strdup(ws->name);
-	wl_list_insert(&output->hotspots, &hotspot->link);
-
 	*x += width;
 	return output->height;
 }
 
-static uint32_t render_to_cairo(cairo_t *cairo, struct swaybar_output *output) {
+static uint32_t render_workspace_buttons(struct render_context *ctx,
+		double *x) {
+	struct swaybar_output *output = ctx->output;
+	struct swaybar_config *config = output->bar->config;
+	uint32_t max_height = 0;
+	struct swaybar_workspace *ws;
+	wl_list_for_each(ws, &output->workspaces, link) {
+		struct box_colors box_colors = workspace_button_colors(config, ws);
+		char *key = NULL;
+		size_t size;
+		FILE *f = key_open(&key, &size, output, "workspace");
+		if (f) {
+			key_add_string(f, ws->label);
+			fprintf(f, "%d;%08x;%08x;%08x;", config->pango_markup,
+					box_colors.background, box_colors.border,
+					box_colors.text);
+		}
+		struct render_element *element = render_element(ctx,
+				key_close(f, key), x, render_workspace_button, ws);
+		uint32_t h = element->ideal_height;
+		max_height = h > max_height ? h : max_height;
+
+		struct swaybar_hotspot *hotspot =
+			calloc(1, sizeof(struct swaybar_hotspot));
+		hotspot->x = element->x;
+		hotspot->y = 0;
+		hotspot->width = element->width;
+		hotspot->height = output->height * output->scale;
+		hotspot->callback = workspace_hotspot_callback;
+		hotspot->destroy = free;
+		hotspot->data = strdup(ws->name);
+		wl_list_insert(&output->hotspots, &hotspot->link);
+	}
+	return max_height;
+}
+
+static uint32_t render_binding_mode(struct render_context *ctx, double *x) {
+	struct swaybar_output *output = ctx->output;
+	struct swaybar_config *config = output->bar->config;
+	if (!output->bar->mode) {
+		return 0;
+	}
+	char *key = NULL;
+	size_t size;
+	FILE *f = key_open(&key, &size, output, "mode");
+	if (f) {
+		key_add_string(f, output->bar->mode);
+		fprintf(f, "%d;%08x;%08x;%08x;", output->bar->mode_pango_markup,
+				config->colors.binding_mode.background,
+				config->colors.binding_mode.border,
+				config->colors.binding_mode.text);
+	}
+	return render_element(ctx, key_close(f, key), x,
+			render_binding_mode_indicator, NULL)->ideal_height;
+}
+
+#if HAVE_TRAY
+static uint32_t render_tray_element(cairo_t *cairo,
+		struct swaybar_output *output, double *x, void *data) {
+	return render_tray(cairo, output, x);
+}
+#endif
+
+static uint32_t render_elements(struct render_context *ctx) {
+	struct swaybar_output *output = ctx->output;
 	struct swaybar *bar = output->bar;
 	struct swaybar_config *config = bar->config;
-	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
-	if (output->focused) {
-		cairo_set_source_u32(cairo, config->colors.focused_background);
-	} else {
-		cairo_set_source_u32(cairo, config->colors.background);
-	}
-	cairo_paint(cairo);
 
+	cairo_surface_t *measure = cairo_recording_surface_create(
+			CAIRO_CONTENT_COLOR_ALPHA, NULL);
+	cairo_t *cairo = cairo_create(measure);
+	cairo_set_font_options(cairo, ctx->font_options);
 	int th;
 	get_text_size(cairo, config->font, NULL, &th, NULL, output->scale, false, "");
+	cairo_destroy(cairo);
+	cairo_surface_destroy(measure);
 	uint32_t max_height = (th + WS_VERTICAL_PADDING * 4) / output->scale;
 	/*
 	 * Each render_* function takes the actual height of the bar, and returns
@@ -475,30 +812,67 @@ static uint32_t render_to_cairo(cairo_t *cairo, struct swaybar_output *output) {
 	double x = output->width * output->scale;
 #if HAVE_TRAY
 	if (bar->tray) {
-		uint32_t h = render_tray(cairo, output, &x);
+		// Tray icons can change without the tray knowing, so the tray is
+		// drawn every frame and compared with the last one instead
+		uint32_t h = render_element(ctx, NULL, &x,
+				render_tray_element, NULL)->ideal_height;
 		max_height = h > max_height ? h : max_height;
 	}
 #endif
 	if (bar->status) {
-		uint32_t h = render_status_line(cairo, output, &x);
+		uint32_t h = render_status_line(ctx, &x);
 		max_height = h > max_height ? h : max_height;
 	}
 	x = 0;
 	if (config->workspace_buttons) {
-		struct swaybar_workspace *ws;
-		wl_list_for_each(ws, &output->workspaces, link) {
-			uint32_t h = render_workspace_button(cairo, output, ws, &x);
-			max_height = h > max_height ? h : max_height;
-		}
+		uint32_t h = render_workspace_buttons(ctx, &x);
+		max_height = h > max_height ? h : max_height;
 	}
 	if (config->binding_mode_indicator) {
-		uint32_t h = render_binding_mode_indicator(cairo, output, x);
+		uint32_t h = render_binding_mode(ctx, &x);
 		max_height = h > max_height ? h : max_height;
 	}
 
 	return max_height > output->height ? max_height : output->height;
 }
 
+/**
+ * Brings the canvas up to date in the damaged area, by painting the
+ * background and the elements over it.
+ */
+static void render_canvas(struct render_context *ctx) {
+	cairo_t *cairo = cairo_create(ctx->output->canvas);
+	int nrects = cairo_region_num_rectangles(ctx->damage);
+	for (int i = 0; i < nrects; ++i) {
+		cairo_rectangle_int_t rect;
+		cairo_region_get_rectangle(ctx->damage, i, &rect);
+		cairo_rectangle(cairo, rect.x, rect.y, rect.width, rect.height);
+	}
+	cairo_clip(cairo);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	cairo_set_source_u32(cairo, ctx->background);
+	cairo_paint(cairo);
+	for (int i = 0; i < ctx->elements->length; ++i) {
+		struct render_element *element = ctx->elements->items[i];
+		if (!element->image) {
+			continue;
+		}
+		cairo_rectangle_int_t rect = {
+			.x = element->x,
+			.width = element->width,
+			.height = cairo_image_surface_get_height(element->image),
+		};
+		if (cairo_region_contains_rectangle(ctx->damage, &rect) ==
+				CAIRO_REGION_OVERLAP_OUT) {
+			continue;
+		}
+		cairo_set_source_surface(cairo, element->image, element->x, 0);
+		cairo_rectangle(cairo, rect.x, rect.y, rect.width, rect.height);
+		cairo_fill(cairo);
+	}
+	cairo_destroy(cairo);
+}
+
 static void output_frame_handle_done(void *data, struct wl_callback *callback,
 		uint32_t time) {
 	wl_callback_destroy(callback);
@@ -522,25 +896,46 @@ void render_frame(struct swaybar_output *output) {
 
 	free_hotspots(&output->hotspots);
 
-	cairo_surface_t *recorder = cairo_recording_surface_create(
-			CAIRO_CONTENT_COLOR_ALPHA, NULL);
-	cairo_t *cairo = cairo_create(recorder);
-	cairo_set_antialias(cairo, CAIRO_ANTIALIAS_BEST);
-	cairo_font_options_t *fo = cairo_font_options_create();
-	cairo_font_options_set_hint_style(fo, CAIRO_HINT_STYLE_FULL);
-	cairo_font_options_set_antialias(fo, CAIRO_ANTIALIAS_SUBPIXEL);
-	cairo_font_options_set_subpixel_order(fo, to_cairo_subpixel_order(output->subpixel));
-	cairo_set_font_options(cairo, fo);
-	cairo_font_options_destroy(fo);
-	cairo_save(cairo);
-	cairo_set_operator(cairo, CAIRO_OPERATOR_CLEAR);
-	cairo_paint(cairo);
-	cairo_restore(cairo);
-	uint32_t height = render_to_cairo(cairo, output);
+	struct swaybar_config *config = output->bar->config;
+	uint32_t background = output->focused ?
+		config->colors.focused_background : config->colors.background;
+	int buffer_width = output->width * output->scale;
+	int buffer_height = output->height * output->scale;
+	if (output->canvas && (output->canvas_background != background ||
+			output->canvas_subpixel != output->subpixel ||
+			cairo_image_surface_get_width(output->canvas) != buffer_width ||
+			cairo_image_surface_get_height(output->canvas) != buffer_height)) {
+		free_render_cache(output);
+	}
+
+	struct render_context ctx = {
+		.output = output,
+		.font_options = cairo_font_options_create(),
+		.background = background,
+		.old_elements = output->elements ? output->elements : create_list(),
+		.elements = create_list(),
+		.damage = cairo_region_create(),
+	};
+	output->elements = NULL;
+	cairo_font_options_set_hint_style(ctx.font_options, CAIRO_HINT_STYLE_FULL);
+	cairo_font_options_set_antialias(ctx.font_options, CAIRO_ANTIALIAS_SUBPIXEL);
+	cairo_font_options_set_subpixel_order(ctx.font_options,
+			to_cairo_subpixel_order(output->subpixel));
+
+	uint32_t height = render_elements(&ctx);
 	int config_height = output->bar->config->height;
 	if (config_height > 0) {
 		height = config_height;
 	}
+
+	// Whatever is left from the last frame is gone now
+	for (int i = 0; i < ctx.old_elements->length; ++i) {
+		damage_element(&ctx, ctx.old_elements->items[i]);
+		render_element_destroy(ctx.old_elements->items[i]);
+	}
+	list_free(ctx.old_elements);
+	output->elements = ctx.elements;
+
 	if (height != output->height || output->width == 0) {
 		// Reconfigure surface
 		zwlr_layer_surface_v1_set_size(output->layer_surface, 0, height);
@@ -555,32 +950,50 @@ void render_frame(struct swaybar_output *output) {
 		// TODO: this could infinite loop if the compositor assigns us a
 		// different height than what we asked for
 		wl_surface_commit(output->surface);
+		// The elements were drawn for the old height
+		free_render_cache(output);
 	} else if (height > 0) {
-		// Replay recording into shm and send it off
+		if (!output->canvas) {
+			output->canvas = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+					buffer_width, buffer_height);
+			output->canvas_background = background;
+			output->canvas_subpixel = output->subpixel;
+			cairo_rectangle_int_t rect = {
+				.width = buffer_width,
+				.height = buffer_height,
+			};
+			cairo_region_union_rectangle(ctx.damage, &rect);
+		}
+		if (cairo_region_is_empty(ctx.damage)) {
+			// Nothing changed since the last frame
+			goto cleanup;
+		}
+		render_canvas(&ctx);
+
 		output->current_buffer = get_next_buffer(output->bar->shm,
-				output->buffers,
-				output->width * output->scale,
-				output->height * output->scale);
+				&output->buffer_pool, buffer_width, buffer_height);
 		if (!output->current_buffer) {
-			cairo_surface_destroy(recorder);
-			cairo_destroy(cairo);
-			return;
+			// The canvas is ahead of what was committed now
+			free_render_cache(output);
+			goto cleanup;
 		}
 		cairo_t *shm = output->current_buffer->cairo;
-
 		cairo_save(shm);
-		cairo_set_operator(shm, CAIRO_OPERATOR_CLEAR);
+		cairo_set_operator(shm, CAIRO_OPERATOR_SOURCE);
+		cairo_set_source_surface(shm, output->canvas, 0.0, 0.0);
 		cairo_paint(shm);
 		cairo_restore(shm);
 
-		cairo_set_source_surface(shm, recorder, 0.0, 0.0);
-		cairo_paint(shm);
-
 		wl_surface_set_buffer_scale(output->surface, output->scale);
 		wl_surface_attach(output->surface,
 				output->current_buffer->buffer, 0, 0);
-		wl_surface_damage(output->surface, 0, 0,
-				output->width, output->height);
+		int nrects = cairo_region_num_rectangles(ctx.damage);
+		for (int i = 0; i < nrects; ++i) {
+			cairo_rectangle_int_t rect;
+			cairo_region_get_rectangle(ctx.damage, i, &rect);
+			wl_surface_damage_buffer(output->surface,
+					rect.x, rect.y, rect.width, rect.height);
+		}
 
 		struct wl_callback *frame_callback = wl_surface_frame(output->surface);
 		wl_callback_add_listener(frame_callback, &output_frame_listener, output);
@@ -588,6 +1001,8 @@ void render_frame(struct swaybar_output *output) {
 
 		wl_surface_commit(output->surface);
 	}
-	cairo_surface_destroy(recorder);
-	cairo_destroy(cairo);
+
+cleanup:
+	cairo_region_destroy(ctx.damage);
+	cairo_font_options_destroy(ctx.font_options);
 }
@@ -1,4 +1,5 @@
 #define _POSIX_C_SOURCE 200809L
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <json.h>
@@ -31,6 +32,98 @@ void status_error(struct status_line *status, const char *text) {
 	status->text = text;
 }
 
+/**
+ * Shows the len bytes at line as the status text. Returns true if the text
+ * changed.
+ */
+static bool text_set_line(struct status_line *status, const char *line,
+		size_t len) {
+	if (status->text_line && strlen(status->text_line) == len &&
+			memcmp(status->text_line, line, len) == 0) {
+		return false;
+	}
+	if (len + 1 > status->text_line_size) {
+		char *text_line = realloc(status->text_line, len + 1);
+		if (!text_line) {
+			sway_log(SWAY_ERROR, "Unable to allocate status line");
+			return false;
+		}
+		status->text_line = text_line;
+		status->text_line_size = len + 1;
+	}
+	memcpy(status->text_line, line, len);
+	status->text_line[len] = '\0';
+	status->text = status->text_line;
+	return true;
+}
+
+/**
+ * Shows the last complete line in the buffer and drops everything before it,
+ * given that the bytes before start don't have a newline. Returns true if the
+ * text changed.
+ */
+static bool text_take_line(struct status_line *status, size_t start) {
+	size_t end = status->buffer_index;
+	while (end > start && status->buffer[end - 1] != '\n') {
+		--end;
+	}
+	if (end == start) {
+		return false;
+	}
+	size_t line = end - 1;
+	while (line > 0 && status->buffer[line - 1] != '\n') {
+		--line;
+	}
+	bool changed = text_set_line(status, status->buffer + line,
+			end - 1 - line);
+	status->buffer_index -= end;
+	memmove(status->buffer, status->buffer + end, status->buffer_index);
+	return changed;
+}
+
+/**
+ * Reads everything the status command has written so far, and shows the last
+ * complete line of it. Earlier lines are dropped without being shown.
+ */
+static bool text_handle_readable(struct status_line *status) {
+	bool changed = false;
+	while (true) {
+		if (status->buffer_index == status->buffer_size) {
+			size_t size = status->buffer_size * 2;
+			char *buffer = realloc(status->buffer, size);
+			if (!buffer) {
+				sway_log_errno(SWAY_ERROR, "Unable to read status line");
+				status_error(status, "[error reading from status command]");
+				return true;
+			}
+			status->buffer = buffer;
+			status->buffer_size = size;
+		}
+
+		size_t start = status->buffer_index;
+		errno = 0;
+		ssize_t read_bytes = read(status->read_fd, status->buffer + start,
+				status->buffer_size - start);
+		if (read_bytes < 0 && errno == EAGAIN) {
+			break;
+		} else if (read_bytes < 0) {
+			status_error(status, "[error reading from status command]");
+			return true;
+		} else if (read_bytes == 0) {
+			// The last line doesn't need a newline when the command exits
+			if (status->buffer_index > 0) {
+				changed |= text_set_line(status, status->buffer,
+						status->buffer_index);
+				status->buffer_index = 0;
+			}
+			break;
+		}
+		status->buffer_index += read_bytes;
+		changed |= text_take_line(status, start);
+	}
+	return changed;
+}
+
 bool status_handle_readable(struct status_line *status) {
 	ssize_t read_bytes = 1;
 	switch (status->protocol) {
@@ -96,7 +189,7 @@ bool status_handle_readable(struct status_line *status) {
 			json_object_put(header);
 
 			wl_list_init(&status->blocks);
-			status->tokener = json_tokener_new();
+			i3bar_parser_init(&status->parser);
 			status->buffer_index = strlen(newline + 1);
 			memmove(status->buffer, newline + 1, status->buffer_index + 1);
 			return i3bar_handle_readable(status);
@@ -104,24 +197,11 @@ bool status_handle_readable(struct status_line *status) {
 
 		sway_log(SWAY_DEBUG, "Using text protocol.");
 		status->protocol = PROTOCOL_TEXT;
-		status->text = status->buffer;
-		// intentional fall-through
+		status->buffer_index = available_bytes;
+		bool changed = text_take_line(status, 0);
+		return text_handle_readable(status) || changed;
 	case PROTOCOL_TEXT:
-		errno = 0;
-		while (true) {
-			if (status->buffer[read_bytes - 1] == '\n') {
-				status->buffer[read_bytes - 1] = '\0';
-			}
-			read_bytes = getline(&status->buffer,
-					&status->buffer_size, status->read);
-			if (errno == EAGAIN) {
-				clearerr(status->read);
-				return true;
-			} else if (errno) {
-				status_error(status, "[error reading from status command]");
-				return true;
-			}
-		}
+		return text_handle_readable(status);
 	case PROTOCOL_I3BAR:
 		return i3bar_handle_readable(status);
 	default:
@@ -166,7 +246,6 @@ struct status_line *status_line_init(char *cmd) {
 	status->write_fd = pipe_write_fd[1];
 	fcntl(status->write_fd, F_SETFL, O_NONBLOCK);
 
-	status->read = fdopen(status->read_fd, "r");
 	status->write = fdopen(status->write_fd, "w");
 	return status;
 }
@@ -180,8 +259,9 @@ void status_line_free(struct status_line *status) {
 			wl_list_remove(&block->link);
 			i3bar_block_unref(block);
 		}
-		json_tokener_free(status->tokener);
+		i3bar_parser_finish(&status->parser);
 	}
+	free(status->text_line);
 	free(status->buffer);
 	free(status);
 }
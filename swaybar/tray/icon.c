@@ -59,10 +59,47 @@ static list_t *get_basedirs(void) {
 	return basedirs_expanded;
 }
 
+static const char *extensions[] = {
+#if HAVE_GDK_PIXBUF
+	"svg",
+#endif
+	"png",
+#if HAVE_GDK_PIXBUF
+	"xpm"
+#endif
+};
+
+/**
+ * A place where an icon of a theme was found, in the order the icon should
+ * be looked for: basedirs first to last, subdirs last to first.
+ */
+struct icon_location {
+	int basedir; // index in basedirs
+	int subdir; // index in icon_theme::subdirs
+	int extension; // index in extensions
+};
+
+struct icon_theme_icon {
+	char *name;
+	struct icon_location *locations;
+	int length, capacity;
+};
+
+static void destroy_icon(const void *key, void *value, void *data) {
+	struct icon_theme_icon *icon = value;
+	free(icon->name);
+	free(icon->locations);
+	free(icon);
+}
+
 static void destroy_theme(struct icon_theme *theme) {
 	if (!theme) {
 		return;
 	}
+	if (theme->icons) {
+		hash_table_for_each(theme->icons, destroy_icon, NULL);
+		hash_table_free(theme->icons);
+	}
 	free(theme->name);
 	free(theme->comment);
 	free(theme->inherits);
@@ -342,6 +379,117 @@ static void log_loaded_themes(list_t *themes) {
 	free(str);
 }
 
+static void add_icon_location(hash_table_t *icons, const char *file,
+		int basedir, int subdir) {
+	const char *dot = strrchr(file, '.');
+	if (!dot || dot == file) {
+		return;
+	}
+	int extension = -1;
+	for (size_t i = 0; i < sizeof(extensions) / sizeof(*extensions); ++i) {
+		if (strcmp(dot + 1, extensions[i]) == 0) {
+			extension = i;
+			break;
+		}
+	}
+	if (extension == -1) {
+		return;
+	}
+
+	char *name = strndup(file, dot - file);
+	if (!name) {
+		return;
+	}
+	struct icon_theme_icon *icon = hash_table_get(icons, name);
+	if (!icon) {
+		icon = calloc(1, sizeof(struct icon_theme_icon));
+		if (!icon) {
+			free(name);
+			return;
+		}
+		icon->name = name;
+		hash_table_set(icons, icon->name, icon);
+	} else {
+		free(name);
+	}
+
+	// The same icon with another extension in the same subdir
+	if (icon->length > 0) {
+		struct icon_location *last = &icon->locations[icon->length - 1];
+		if (last->basedir == basedir && last->subdir == subdir) {
+			if (extension < last->extension) {
+				last->extension = extension;
+			}
+			return;
+		}
+	}
+
+	if (icon->length == icon->capacity) {
+		int capacity = icon->capacity ? icon->capacity * 2 : 2;
+		struct icon_location *locations = realloc(icon->locations,
+				capacity * sizeof(struct icon_location));
+		if (!locations) {
+			return;
+		}
+		icon->locations = locations;
+		icon->capacity = capacity;
+	}
+	icon->locations[icon->length++] = (struct icon_location){
+		.basedir = basedir,
+		.subdir = subdir,
+		.extension = extension,
+	};
+}
+
+/*
+ * Reads the subdirs of the theme in every basedir once, so that looking up
+ * an icon is a hash table lookup instead of trying every possible path.
+ */
+static void index_theme(struct icon_theme *theme, list_t *basedirs) {
+	theme->icons = create_hash_table(hash_string, equal_string);
+	if (!theme->icons) {
+		return;
+	}
+	for (int i = 0; i < basedirs->length; ++i) {
+		// search backwards to hopefully hit scalable/larger icons first
+		for (int j = theme->subdirs->length - 1; j >= 0; --j) {
+			struct icon_theme_subdir *subdir = theme->subdirs->items[j];
+			size_t path_len = snprintf(NULL, 0, "%s/%s/%s",
+					(char *)basedirs->items[i], theme->dir, subdir->name) + 1;
+			char *path = malloc(path_len);
+			if (!path) {
+				continue;
+			}
+			snprintf(path, path_len, "%s/%s/%s",
+					(char *)basedirs->items[i], theme->dir, subdir->name);
+			DIR *dir = opendir(path);
+			free(path);
+			if (!dir) {
+				continue;
+			}
+			struct dirent *entry;
+			while ((entry = readdir(dir))) {
+				if (entry->d_name[0] != '.') {
+					add_icon_location(theme->icons, entry->d_name, i, j);
+				}
+			}
+			closedir(dir);
+		}
+	}
+	sway_log(SWAY_DEBUG, "Indexed %d icons in theme %s",
+			theme->icons->length, theme->name);
+}
+
+static struct icon_theme *find_theme(list_t *themes, const char *name) {
+	for (int i = 0; i < themes->length; ++i) {
+		struct icon_theme *theme = themes->items[i];
+		if (strcmp(theme->name, name) == 0) {
+			return theme;
+		}
+	}
+	return NULL;
+}
+
 void init_themes(list_t **themes, list_t **basedirs) {
 	*basedirs = get_basedirs();
 
@@ -351,6 +499,12 @@ void init_themes(list_t **themes, list_t **basedirs) {
 		list_cat(*themes, dir_themes);
 		list_free(dir_themes);
 	}
+	for (int i = 0; i < (*themes)->length; ++i) {
+		struct icon_theme *theme = (*themes)->items[i];
+		if (find_theme(*themes, theme->name) == theme) {
+			index_theme(theme, *basedirs);
+		}
+	}
 
 	log_loaded_themes(*themes);
 }
@@ -365,16 +519,6 @@ void finish_themes(list_t *themes, list_t *basedirs) {
 
 static char *find_icon_in_subdir(char *name, char *basedir, char *theme,
 		char *subdir) {
-	static const char *extensions[] = {
-#if HAVE_GDK_PIXBUF
-		"svg",
-#endif
-		"png",
-#if HAVE_GDK_PIXBUF
-		"xpm"
-#endif
-	};
-
 	size_t path_len = snprintf(NULL, 0, "%s/%s/%s/%s.EXT", basedir, theme,
 			subdir, name) + 1;
 	char *path = malloc(path_len);
@@ -391,75 +535,66 @@ static char *find_icon_in_subdir(char *name, char *basedir, char *theme,
 	return NULL;
 }
 
-static bool theme_exists_in_basedir(char *theme, char *basedir) {
-	size_t path_len = snprintf(NULL, 0, "%s/%s", basedir, theme) + 1;
+static char *icon_location_path(list_t *basedirs, struct icon_theme *theme,
+		struct icon_theme_icon *icon, struct icon_location *location) {
+	struct icon_theme_subdir *subdir = theme->subdirs->items[location->subdir];
+	char *basedir = basedirs->items[location->basedir];
+	const char *extension = extensions[location->extension];
+	size_t path_len = snprintf(NULL, 0, "%s/%s/%s/%s.%s", basedir,
+			theme->dir, subdir->name, icon->name, extension) + 1;
 	char *path = malloc(path_len);
-	snprintf(path, path_len, "%s/%s", basedir, theme);
-	bool ret = dir_exists(path);
-	free(path);
-	return ret;
+	if (path) {
+		snprintf(path, path_len, "%s/%s/%s/%s.%s", basedir,
+				theme->dir, subdir->name, icon->name, extension);
+	}
+	return path;
 }
 
 static char *find_icon_with_theme(list_t *basedirs, list_t *themes, char *name,
 		int size, char *theme_name, int *min_size, int *max_size) {
-	struct icon_theme *theme = NULL;
-	for (int i = 0; i < themes->length; ++i) {
-		theme = themes->items[i];
-		if (strcmp(theme->name, theme_name) == 0) {
-			break;
-		}
-		theme = NULL;
-	}
+	struct icon_theme *theme = find_theme(themes, theme_name);
 	if (!theme) return NULL;
 
-	char *icon = NULL;
-	for (int i = 0; i < basedirs->length; ++i) {
-		if (!theme_exists_in_basedir(theme->dir, basedirs->items[i])) {
-			continue;
-		}
-		// search backwards to hopefully hit scalable/larger icons first
-		for (int j = theme->subdirs->length - 1; j >= 0; --j) {
-			struct icon_theme_subdir *subdir = theme->subdirs->items[j];
+	struct icon_theme_icon *icon =
+		theme->icons ? hash_table_get(theme->icons, name) : NULL;
+	if (icon) {
+		for (int i = 0; i < icon->length; ++i) {
+			struct icon_location *location = &icon->locations[i];
+			struct icon_theme_subdir *subdir =
+				theme->subdirs->items[location->subdir];
 			if (size >= subdir->min_size && size <= subdir->max_size) {
-				if ((icon = find_icon_in_subdir(name, basedirs->items[i],
-								theme->dir, subdir->name))) {
-					*min_size = subdir->min_size;
-					*max_size = subdir->max_size;
-					return icon;
-				}
+				*min_size = subdir->min_size;
+				*max_size = subdir->max_size;
+				return icon_location_path(basedirs, theme, icon, location);
 			}
 		}
-	}
 
-	// inexact match
-	unsigned smallest_error = -1; // UINT_MAX
-	for (int i = 0; i < basedirs->length; ++i) {
-		if (!theme_exists_in_basedir(theme->dir, basedirs->items[i])) {
-			continue;
-		}
-		for (int j = theme->subdirs->length - 1; j >= 0; --j) {
-			struct icon_theme_subdir *subdir = theme->subdirs->items[j];
+		// inexact match
+		struct icon_location *best = NULL;
+		unsigned smallest_error = -1; // UINT_MAX
+		for (int i = 0; i < icon->length; ++i) {
+			struct icon_location *location = &icon->locations[i];
+			struct icon_theme_subdir *subdir =
+				theme->subdirs->items[location->subdir];
 			unsigned error = (size > subdir->max_size ? size - subdir->max_size : 0)
 				+ (size < subdir->min_size ? subdir->min_size - size : 0);
 			if (error < smallest_error) {
-				char *test_icon = find_icon_in_subdir(name, basedirs->items[i],
-						theme->dir, subdir->name);
-				if (test_icon) {
-					icon = test_icon;
-					smallest_error = error;
-					*min_size = subdir->min_size;
-					*max_size = subdir->max_size;
-				}
+				best = location;
+				smallest_error = error;
+				*min_size = subdir->min_size;
+				*max_size = subdir->max_size;
 			}
 		}
+		if (best) {
+			return icon_location_path(basedirs, theme, icon, best);
+		}
 	}
 
-	if (!icon && theme->inherits) {
-		icon = find_icon_with_theme(basedirs, themes, name, size,
+	if (theme->inherits) {
+		return find_icon_with_theme(basedirs, themes, name, size,
 				theme->inherits, min_size, max_size);
 	}
-
-	return icon;
+	return NULL;
 }
 
 char *find_icon_in_dir(char *name, char *dir, int *min_size, int *max_size) {
@@ -25,9 +25,25 @@ static bool sni_ready(struct swaybar_sni *sni) {
 			sni->icon_name || sni->icon_pixmap);
 }
 
+static void flush_scaled_icons(struct swaybar_sni *sni) {
+	for (int i = 0; i < SNI_SCALED_ICONS; ++i) {
+		cairo_surface_destroy(sni->scaled_icons[i].surface);
+		sni->scaled_icons[i].surface = NULL;
+	}
+}
+
+static void set_sni_icon(struct swaybar_sni *sni, cairo_surface_t *icon) {
+	// Icons drawn at other sizes stay cached, they came from the same icon
+	// looked up for another size. set_sni_dirty drops them when it changes.
+	cairo_surface_destroy(sni->icon);
+	sni->icon = icon;
+}
+
 static void set_sni_dirty(struct swaybar_sni *sni) {
+	flush_scaled_icons(sni);
 	if (sni_ready(sni)) {
-		sni->min_size = sni->max_size = 0; // invalidate previous icon
+		// invalidate previous icon
+		sni->min_size = sni->max_size = sni->target_size = 0;
 		set_bar_dirty(sni->tray->bar);
 	}
 }
@@ -306,6 +322,7 @@ void destroy_sni(struct swaybar_sni *sni) {
 	}
 
 	cairo_surface_destroy(sni->icon);
+	flush_scaled_icons(sni);
 
 	sd_bus_slot_unref(sni->new_icon_slot);
 	sd_bus_slot_unref(sni->new_attention_icon_slot);
@@ -401,12 +418,75 @@ static enum hotspot_event_handling icon_hotspot_callback(
 	return HOTSPOT_PROCESS;
 }
 
+static cairo_surface_t *draw_sni_icon(struct swaybar_sni *sni,
+		int ideal_size) {
+	if (sni->icon) {
+		int actual_size = cairo_image_surface_get_height(sni->icon);
+		int icon_size = actual_size < ideal_size ?
+			actual_size*(ideal_size/actual_size) : ideal_size;
+		return cairo_image_surface_scale(sni->icon, icon_size, icon_size);
+	}
+
+	// draw a :(
+	int icon_size = ideal_size*0.8;
+	cairo_surface_t *icon =
+		cairo_image_surface_create(CAIRO_FORMAT_ARGB32, icon_size, icon_size);
+	cairo_t *cairo_icon = cairo_create(icon);
+	cairo_set_source_u32(cairo_icon, 0xFF0000FF);
+	cairo_translate(cairo_icon, icon_size/2, icon_size/2);
+	cairo_scale(cairo_icon, icon_size/2, icon_size/2);
+	cairo_arc(cairo_icon, 0, 0, 1, 0, 7);
+	cairo_fill(cairo_icon);
+	cairo_set_operator(cairo_icon, CAIRO_OPERATOR_CLEAR);
+	cairo_arc(cairo_icon, 0.35, -0.3, 0.1, 0, 7);
+	cairo_fill(cairo_icon);
+	cairo_arc(cairo_icon, -0.35, -0.3, 0.1, 0, 7);
+	cairo_fill(cairo_icon);
+	cairo_arc(cairo_icon, 0, 0.75, 0.5, 3.71238898038469, 5.71238898038469);
+	cairo_set_line_width(cairo_icon, 0.1);
+	cairo_stroke(cairo_icon);
+	cairo_destroy(cairo_icon);
+	return icon;
+}
+
+/**
+ * Returns the icon as drawn at the given size if it is cached, and makes it
+ * the most recently used.
+ */
+static cairo_surface_t *get_scaled_icon(struct swaybar_sni *sni, int size) {
+	struct swaybar_scaled_icon *icons = sni->scaled_icons;
+	for (int i = 0; i < SNI_SCALED_ICONS && icons[i].surface; ++i) {
+		if (icons[i].size == size) {
+			struct swaybar_scaled_icon found = icons[i];
+			memmove(&icons[1], &icons[0], i * sizeof(*icons));
+			icons[0] = found;
+			return found.surface;
+		}
+	}
+	return NULL;
+}
+
+// Caches the icon as drawn at size, evicting the least recently used one
+static void add_scaled_icon(struct swaybar_sni *sni, cairo_surface_t *surface,
+		int size) {
+	struct swaybar_scaled_icon *icons = sni->scaled_icons;
+	cairo_surface_destroy(icons[SNI_SCALED_ICONS - 1].surface);
+	memmove(&icons[1], &icons[0], (SNI_SCALED_ICONS - 1) * sizeof(*icons));
+	icons[0].surface = surface;
+	icons[0].size = size;
+}
+
 uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 		struct swaybar_sni *sni) {
 	uint32_t height = output->height * output->scale;
 	int padding = output->bar->config->tray_padding;
 	int ideal_size = height - 2*padding;
-	if ((ideal_size < sni->min_size || ideal_size > sni->max_size) && sni_ready(sni)) {
+	cairo_surface_t *icon = get_scaled_icon(sni, ideal_size);
+	// Look the icon up again if it doesn't suit the size, unless it was the
+	// best there is for that size already
+	if (!icon && (ideal_size < sni->min_size || ideal_size > sni->max_size) &&
+			ideal_size != sni->target_size && sni_ready(sni)) {
+		sni->target_size = ideal_size;
 		bool icon_found = false;
 		char *icon_name = sni->status[0] == 'N' ?
 			sni->attention_icon_name : sni->icon_name;
@@ -419,8 +499,7 @@ uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 						&sni->min_size, &sni->max_size);
 			}
 			if (icon_path) {
-				cairo_surface_destroy(sni->icon);
-				sni->icon = load_background_image(icon_path);
+				set_sni_icon(sni, load_background_image(icon_path));
 				free(icon_path);
 				icon_found = true;
 			}
@@ -441,40 +520,20 @@ uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 					}
 				}
 				struct swaybar_pixmap *pixmap = pixmaps->items[idx];
-				cairo_surface_destroy(sni->icon);
-				sni->icon = cairo_image_surface_create_for_data(pixmap->pixels,
-						CAIRO_FORMAT_ARGB32, pixmap->size, pixmap->size,
-						cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, pixmap->size));
+				set_sni_icon(sni, cairo_image_surface_create_for_data(
+						pixmap->pixels, CAIRO_FORMAT_ARGB32,
+						pixmap->size, pixmap->size,
+						cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32,
+							pixmap->size)));
 			}
 		}
 	}
 
-	int icon_size;
-	cairo_surface_t *icon;
-	if (sni->icon) {
-		int actual_size = cairo_image_surface_get_height(sni->icon);
-		icon_size = actual_size < ideal_size ?
-			actual_size*(ideal_size/actual_size) : ideal_size;
-		icon = cairo_image_surface_scale(sni->icon, icon_size, icon_size);
-	} else { // draw a :(
-		icon_size = ideal_size*0.8;
-		icon = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, icon_size, icon_size);
-		cairo_t *cairo_icon = cairo_create(icon);
-		cairo_set_source_u32(cairo_icon, 0xFF0000FF);
-		cairo_translate(cairo_icon, icon_size/2, icon_size/2);
-		cairo_scale(cairo_icon, icon_size/2, icon_size/2);
-		cairo_arc(cairo_icon, 0, 0, 1, 0, 7);
-		cairo_fill(cairo_icon);
-		cairo_set_operator(cairo_icon, CAIRO_OPERATOR_CLEAR);
-		cairo_arc(cairo_icon, 0.35, -0.3, 0.1, 0, 7);
-		cairo_fill(cairo_icon);
-		cairo_arc(cairo_icon, -0.35, -0.3, 0.1, 0, 7);
-		cairo_fill(cairo_icon);
-		cairo_arc(cairo_icon, 0, 0.75, 0.5, 3.71238898038469, 5.71238898038469);
-		cairo_set_line_width(cairo_icon, 0.1);
-		cairo_stroke(cairo_icon);
-		cairo_destroy(cairo_icon);
+	if (!icon) {
+		icon = draw_sni_icon(sni, ideal_size);
+		add_scaled_icon(sni, icon, ideal_size);
 	}
+	int icon_size = cairo_image_surface_get_height(icon);
 
 	int padded_size = icon_size + 2*padding;
 	*x -= padded_size;
@@ -487,8 +546,6 @@ uint32_t render_sni(cairo_t *cairo, struct swaybar_output *output, double *x,
 	cairo_fill(cairo);
 	cairo_set_operator(cairo, op);
 
-	cairo_surface_destroy(icon);
-
 	struct swaybar_hotspot *hotspot = calloc(1, sizeof(struct swaybar_hotspot));
 	hotspot->x = *x;
 	hotspot->y = 0;
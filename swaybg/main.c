@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include <assert.h>
 #include <ctype.h>
 #include <stdbool.h>
@@ -16,47 +17,60 @@
 
 struct swaybg_state;
 
+/**
+ * A decoded wallpaper, shared by all the outputs using the same path.
+ */
+struct swaybg_image {
+	const char *path;
+	cairo_surface_t *surface;
+	struct wl_list link;
+};
+
+struct swaybg_context {
+	uint32_t color;
+	struct swaybg_image *image;
+};
+
 struct swaybg_args {
 	const char *output;
 	const char *path;
 	enum background_mode mode;
 	const char *fallback;
-};
+	bool valid; // invalid sets are skipped, their outputs get no background
 
-struct swaybg_context {
-	uint32_t color;
-	cairo_surface_t *image;
+	struct swaybg_context context;
 };
 
 struct swaybg_output {
+	uint32_t wl_name;
 	struct wl_output *wl_output;
 	struct zxdg_output_v1 *xdg_output;
+	char *name;
 	struct swaybg_state *state;
 	struct wl_list link;
 
+	const struct swaybg_args *args; // NULL if it has no background
+	struct wl_surface *surface;
+	struct wl_region *input_region;
+	struct zwlr_layer_surface_v1 *layer_surface;
+
 	int32_t scale;
+	uint32_t width, height;
+	struct buffer_pool buffer_pool;
+	struct pool_buffer *current_buffer;
 };
 
 struct swaybg_state {
-	const struct swaybg_args *args;
-	struct swaybg_context context;
+	struct swaybg_args *args;
+	int nargs;
+	struct wl_list images; // swaybg_image::link
 
 	struct wl_display *display;
 	struct wl_compositor *compositor;
 	struct wl_shm *shm;
-	struct wl_list outputs;
+	struct wl_list outputs; // swaybg_output::link
 	struct zwlr_layer_shell_v1 *layer_shell;
 	struct zxdg_output_manager_v1 *xdg_output_manager;
-
-	struct swaybg_output *output;
-	struct wl_surface *surface;
-	struct wl_region *input_region;
-	struct zwlr_layer_surface_v1 *layer_surface;
-
-	bool run_display;
-	uint32_t width, height;
-	struct pool_buffer buffers[2];
-	struct pool_buffer *current_buffer;
 };
 
 bool is_valid_color(const char *color) {
@@ -77,68 +91,112 @@ bool is_valid_color(const char *color) {
 	return true;
 }
 
-static void render_frame(struct swaybg_state *state) {
-	int buffer_width = state->width * state->output->scale,
-		buffer_height = state->height * state->output->scale;
-	state->current_buffer = get_next_buffer(state->shm,
-			state->buffers, buffer_width, buffer_height);
-	if (!state->current_buffer) {
+static void render_frame(struct swaybg_output *output) {
+	const struct swaybg_args *args = output->args;
+	int buffer_width = output->width * output->scale,
+		buffer_height = output->height * output->scale;
+	output->current_buffer = get_next_buffer(output->state->shm,
+			&output->buffer_pool, buffer_width, buffer_height);
+	if (!output->current_buffer) {
 		return;
 	}
-	cairo_t *cairo = state->current_buffer->cairo;
+	cairo_t *cairo = output->current_buffer->cairo;
 	cairo_save(cairo);
 	cairo_set_operator(cairo, CAIRO_OPERATOR_CLEAR);
 	cairo_paint(cairo);
 	cairo_restore(cairo);
-	if (state->args->mode == BACKGROUND_MODE_SOLID_COLOR) {
-		cairo_set_source_u32(cairo, state->context.color);
+	if (args->mode == BACKGROUND_MODE_SOLID_COLOR) {
+		cairo_set_source_u32(cairo, args->context.color);
 		cairo_paint(cairo);
 	} else {
-		if (state->args->fallback && state->context.color) {
-			cairo_set_source_u32(cairo, state->context.color);
+		if (args->fallback && args->context.color) {
+			cairo_set_source_u32(cairo, args->context.color);
 			cairo_paint(cairo);
 		}
-		render_background_image(cairo, state->context.image,
-				state->args->mode, buffer_width, buffer_height);
+		render_background_image(cairo, args->context.image->surface,
+				args->mode, buffer_width, buffer_height);
 	}
 
-	wl_surface_set_buffer_scale(state->surface, state->output->scale);
-	wl_surface_attach(state->surface, state->current_buffer->buffer, 0, 0);
-	wl_surface_damage_buffer(state->surface, 0, 0, INT32_MAX, INT32_MAX);
-	wl_surface_commit(state->surface);
+	wl_surface_set_buffer_scale(output->surface, output->scale);
+	wl_surface_attach(output->surface, output->current_buffer->buffer, 0, 0);
+	wl_surface_damage_buffer(output->surface, 0, 0, INT32_MAX, INT32_MAX);
+	wl_surface_commit(output->surface);
+}
+
+static struct swaybg_image *load_image(struct swaybg_state *state,
+		const char *path) {
+	struct swaybg_image *image;
+	wl_list_for_each(image, &state->images, link) {
+		if (strcmp(image->path, path) == 0) {
+			return image;
+		}
+	}
+
+	cairo_surface_t *surface = load_background_image(path);
+	if (!surface) {
+		return NULL;
+	}
+	image = calloc(1, sizeof(struct swaybg_image));
+	image->path = path;
+	image->surface = surface;
+	wl_list_insert(&state->images, &image->link);
+	return image;
 }
 
-static bool prepare_context(struct swaybg_state *state) {
-	if (state->args->mode == BACKGROUND_MODE_SOLID_COLOR) {
-		state->context.color = parse_color(state->args->path);
-		return is_valid_color(state->args->path);
+static bool prepare_context(struct swaybg_state *state,
+		struct swaybg_args *args) {
+	if (args->mode == BACKGROUND_MODE_SOLID_COLOR) {
+		args->context.color = parse_color(args->path);
+		return is_valid_color(args->path);
 	}
-	if (state->args->fallback && is_valid_color(state->args->fallback)) {
-		state->context.color = parse_color(state->args->fallback);
+	if (args->fallback && is_valid_color(args->fallback)) {
+		args->context.color = parse_color(args->fallback);
 	}
-	if (!(state->context.image = load_background_image(state->args->path))) {
+	if (!(args->context.image = load_image(state, args->path))) {
 		return false;
 	}
 	return true;
 }
 
+static void destroy_layer_surface(struct swaybg_output *output) {
+	if (!output->layer_surface) {
+		return;
+	}
+	zwlr_layer_surface_v1_destroy(output->layer_surface);
+	wl_surface_destroy(output->surface);
+	wl_region_destroy(output->input_region);
+	output->layer_surface = NULL;
+	output->surface = NULL;
+	output->input_region = NULL;
+	output->width = output->height = 0;
+}
+
+static void destroy_output(struct swaybg_output *output) {
+	destroy_layer_surface(output);
+	if (output->xdg_output) {
+		zxdg_output_v1_destroy(output->xdg_output);
+	}
+	wl_output_destroy(output->wl_output);
+	finish_buffer_pool(&output->buffer_pool);
+	wl_list_remove(&output->link);
+	free(output->name);
+	free(output);
+}
+
 static void layer_surface_configure(void *data,
 		struct zwlr_layer_surface_v1 *surface,
 		uint32_t serial, uint32_t width, uint32_t height) {
-	struct swaybg_state *state = data;
-	state->width = width;
-	state->height = height;
+	struct swaybg_output *output = data;
+	output->width = width;
+	output->height = height;
 	zwlr_layer_surface_v1_ack_configure(surface, serial);
-	render_frame(state);
+	render_frame(output);
 }
 
 static void layer_surface_closed(void *data,
 		struct zwlr_layer_surface_v1 *surface) {
-	struct swaybg_state *state = data;
-	zwlr_layer_surface_v1_destroy(state->layer_surface);
-	wl_surface_destroy(state->surface);
-	wl_region_destroy(state->input_region);
-	state->run_display = false;
+	struct swaybg_output *output = data;
+	destroy_layer_surface(output);
 }
 
 static const struct zwlr_layer_surface_v1_listener layer_surface_listener = {
@@ -146,6 +204,34 @@ static const struct zwlr_layer_surface_v1_listener layer_surface_listener = {
 	.closed = layer_surface_closed,
 };
 
+static void create_layer_surface(struct swaybg_output *output) {
+	struct swaybg_state *state = output->state;
+
+	output->surface = wl_compositor_create_surface(state->compositor);
+	assert(output->surface);
+
+	// Empty input region
+	output->input_region = wl_compositor_create_region(state->compositor);
+	assert(output->input_region);
+	wl_surface_set_input_region(output->surface, output->input_region);
+
+	output->layer_surface = zwlr_layer_shell_v1_get_layer_surface(
+			state->layer_shell, output->surface, output->wl_output,
+			ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, "wallpaper");
+	assert(output->layer_surface);
+
+	zwlr_layer_surface_v1_set_size(output->layer_surface, 0, 0);
+	zwlr_layer_surface_v1_set_anchor(output->layer_surface,
+			ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
+			ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT |
+			ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM |
+			ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT);
+	zwlr_layer_surface_v1_set_exclusive_zone(output->layer_surface, -1);
+	zwlr_layer_surface_v1_add_listener(output->layer_surface,
+			&layer_surface_listener, output);
+	wl_surface_commit(output->surface);
+}
+
 static void output_geometry(void *data, struct wl_output *output, int32_t x,
 		int32_t y, int32_t width_mm, int32_t height_mm, int32_t subpixel,
 		const char *make, const char *model, int32_t transform) {
@@ -164,12 +250,11 @@ static void output_done(void *data, struct wl_output *output) {
 static void output_scale(void *data, struct wl_output *wl_output,
 		int32_t scale) {
 	struct swaybg_output *output = data;
-	struct swaybg_state *state = output->state;
 
 	output->scale = scale;
 
-	if (state->output == output && state->run_display) {
-		render_frame(state);
+	if (output->layer_surface && output->width && output->height) {
+		render_frame(output);
 	}
 }
 
@@ -194,9 +279,14 @@ static void xdg_output_handle_name(void *data,
 		struct zxdg_output_v1 *xdg_output, const char *name) {
 	struct swaybg_output *output = data;
 	struct swaybg_state *state = output->state;
-	if (strcmp(name, state->args->output) == 0) {
-		assert(state->output == NULL);
-		state->output = output;
+	free(output->name);
+	output->name = strdup(name);
+	output->args = NULL;
+	for (int i = 0; i < state->nargs; ++i) {
+		if (state->args[i].valid && strcmp(name, state->args[i].output) == 0) {
+			output->args = &state->args[i];
+			break;
+		}
 	}
 }
 
@@ -207,7 +297,12 @@ static void xdg_output_handle_description(void *data,
 
 static void xdg_output_handle_done(void *data,
 		struct zxdg_output_v1 *xdg_output) {
-	// Who cares
+	struct swaybg_output *output = data;
+	if (output->args && !output->layer_surface) {
+		sway_log(SWAY_DEBUG, "Setting background for output %s to %s",
+				output->name, output->args->path);
+		create_layer_surface(output);
+	}
 }
 
 static const struct zxdg_output_v1_listener xdg_output_listener = {
@@ -218,6 +313,13 @@ static const struct zxdg_output_v1_listener xdg_output_listener = {
 	.done = xdg_output_handle_done,
 };
 
+static void add_xdg_output(struct swaybg_output *output) {
+	output->xdg_output = zxdg_output_manager_v1_get_xdg_output(
+		output->state->xdg_output_manager, output->wl_output);
+	zxdg_output_v1_add_listener(output->xdg_output,
+		&xdg_output_listener, output);
+}
+
 static void handle_global(void *data, struct wl_registry *registry,
 		uint32_t name, const char *interface, uint32_t version) {
 	struct swaybg_state *state = data;
@@ -229,10 +331,17 @@ static void handle_global(void *data, struct wl_registry *registry,
 	} else if (strcmp(interface, wl_output_interface.name) == 0) {
 		struct swaybg_output *output = calloc(1, sizeof(struct swaybg_output));
 		output->state = state;
+		output->wl_name = name;
+		output->scale = 1;
 		output->wl_output =
 			wl_registry_bind(registry, name, &wl_output_interface, 3);
 		wl_output_add_listener(output->wl_output, &output_listener, output);
+		init_buffer_pool(&output->buffer_pool, 2);
 		wl_list_insert(&state->outputs, &output->link);
+		// Outputs announced before the manager get their xdg_output in main
+		if (state->xdg_output_manager) {
+			add_xdg_output(output);
+		}
 	} else if (strcmp(interface, zwlr_layer_shell_v1_interface.name) == 0) {
 		state->layer_shell =
 			wl_registry_bind(registry, name, &zwlr_layer_shell_v1_interface, 1);
@@ -244,7 +353,15 @@ static void handle_global(void *data, struct wl_registry *registry,
 
 static void handle_global_remove(void *data, struct wl_registry *registry,
 		uint32_t name) {
-	// who cares
+	struct swaybg_state *state = data;
+	struct swaybg_output *output, *tmp;
+	wl_list_for_each_safe(output, tmp, &state->outputs, link) {
+		if (output->wl_name == name) {
+			sway_log(SWAY_DEBUG, "Destroying output %s", output->name);
+			destroy_output(output);
+			break;
+		}
+	}
 }
 
 static const struct wl_registry_listener registry_listener = {
@@ -255,27 +372,41 @@ static const struct wl_registry_listener registry_listener = {
 int main(int argc, const char **argv) {
 	sway_log_init(SWAY_DEBUG, NULL);
 
-	struct swaybg_args args = {0};
-	struct swaybg_state state = { .args = &args };
+	struct swaybg_state state = {0};
 	wl_list_init(&state.outputs);
+	wl_list_init(&state.images);
 
-	if (argc < 4 || argc > 5) {
+	// Arguments come in sets of "output path mode fallback", with an empty
+	// fallback if there is none. A single set may omit the fallback.
+	if (argc < 4 || (argc != 4 && (argc - 1) % 4 != 0)) {
 		sway_log(SWAY_ERROR, "Do not run this program manually. "
 				"See `man 5 sway-output` and look for background options.");
 		return 1;
 	}
 
-	args.output = argv[1];
-	args.path = argv[2];
-
-	args.mode = parse_background_mode(argv[3]);
-	if (args.mode == BACKGROUND_MODE_INVALID) {
-		return 1;
+	state.nargs = argc == 4 ? 1 : (argc - 1) / 4;
+	state.args = calloc(state.nargs, sizeof(struct swaybg_args));
+	int nvalid = 0;
+	for (int i = 0; i < state.nargs; ++i) {
+		const char **set = &argv[1 + i * 4];
+		struct swaybg_args *args = &state.args[i];
+		args->output = set[0];
+		args->path = set[1];
+		args->fallback = argc == 4 || !*set[3] ? NULL : set[3];
+
+		// Images are only decoded once, for the first output using them
+		args->mode = parse_background_mode(set[2]);
+		args->valid = args->mode != BACKGROUND_MODE_INVALID &&
+			prepare_context(&state, args);
+		if (args->valid) {
+			++nvalid;
+		} else {
+			// One bad background shouldn't cost the other outputs theirs
+			sway_log(SWAY_ERROR, "Skipping the background of output '%s'",
+					args->output);
+		}
 	}
-
-	args.fallback = argc == 5 ? argv[4] : NULL;
-
-	if (!prepare_context(&state)) {
+	if (nvalid == 0) {
 		return 1;
 	}
 
@@ -298,45 +429,26 @@ int main(int argc, const char **argv) {
 
 	struct swaybg_output *output;
 	wl_list_for_each(output, &state.outputs, link) {
-		output->xdg_output = zxdg_output_manager_v1_get_xdg_output(
-			state.xdg_output_manager, output->wl_output);
-		zxdg_output_v1_add_listener(output->xdg_output,
-			&xdg_output_listener, output);
+		if (!output->xdg_output) {
+			add_xdg_output(output);
+		}
 	}
-	// Second roundtrip to get xdg_output properties
+	// Second roundtrip to get xdg_output properties, which creates the
+	// layer surfaces of the outputs with a background
 	wl_display_roundtrip(state.display);
-	if (state.output == NULL) {
-		sway_log(SWAY_ERROR, "Cannot find output '%s'", args.output);
-		return 1;
+	for (int i = 0; i < state.nargs; ++i) {
+		bool found = !state.args[i].valid;
+		wl_list_for_each(output, &state.outputs, link) {
+			found = found || output->args == &state.args[i];
+		}
+		if (!found) {
+			// It gets its background once it's connected or enabled
+			sway_log(SWAY_DEBUG, "Output '%s' isn't there yet",
+					state.args[i].output);
+		}
 	}
 
-	state.surface = wl_compositor_create_surface(state.compositor);
-	assert(state.surface);
-
-	// Empty input region
-	state.input_region = wl_compositor_create_region(state.compositor);
-	assert(state.input_region);
-	wl_surface_set_input_region(state.surface, state.input_region);
-
-	state.layer_surface = zwlr_layer_shell_v1_get_layer_surface(
-			state.layer_shell, state.surface, state.output->wl_output,
-			ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, "wallpaper");
-	assert(state.layer_surface);
-
-	zwlr_layer_surface_v1_set_size(state.layer_surface, 0, 0);
-	zwlr_layer_surface_v1_set_anchor(state.layer_surface,
-			ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
-			ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT |
-			ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM |
-			ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT);
-	zwlr_layer_surface_v1_set_exclusive_zone(state.layer_surface, -1);
-	zwlr_layer_surface_v1_add_listener(state.layer_surface,
-			&layer_surface_listener, &state);
-	wl_surface_commit(state.surface);
-	wl_display_roundtrip(state.display);
-
-	state.run_display = true;
-	while (wl_display_dispatch(state.display) != -1 && state.run_display) {
+	while (wl_display_dispatch(state.display) != -1) {
 		// This space intentionally left blank
 	}
 
@@ -357,6 +357,7 @@ void swaynag_setup(struct swaynag *swaynag) {
 
 	swaynag->scale = 1;
 	wl_list_init(&swaynag->outputs);
+	init_buffer_pool(&swaynag->buffer_pool, 2);
 
 	struct wl_registry *registry = wl_display_get_registry(swaynag->display);
 	wl_registry_add_listener(registry, &registry_listener, swaynag);
@@ -438,13 +439,7 @@ void swaynag_destroy(struct swaynag *swaynag) {
 		wl_cursor_theme_destroy(swaynag->pointer.cursor_theme);
 	}
 
-	if (&swaynag->buffers[0]) {
-		destroy_buffer(&swaynag->buffers[0]);
-	}
-
-	if (&swaynag->buffers[1]) {
-		destroy_buffer(&swaynag->buffers[1]);
-	}
+	finish_buffer_pool(&swaynag->buffer_pool);
 
 	if (swaynag->outputs.prev || swaynag->outputs.next) {
 		struct swaynag_output *output, *temp;
@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200809L
+#include <json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "swaybar/i3bar_parser.h"
+
+#define LINES 20000
+#define BLOCKS 10
+
+static const char *field_names[] = {
+	"full_text", "short_text", "color", "min_width", "align", "urgent",
+	"name", "instance", "separator", "separator_block_width", "markup",
+	"background", "border", "border_top", "border_bottom", "border_left",
+	"border_right",
+};
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Writes a status stream like a status command with BLOCKS blocks would, and
+ * records where each line ends.
+ */
+static char *generate_stream(size_t *ends) {
+	size_t size = 1024 * 1024, len = 0;
+	char *stream = malloc(size);
+	len += sprintf(stream, "[\n");
+	for (int i = 0; i < LINES; ++i) {
+		if (size - len < 4096) {
+			size *= 2;
+			stream = realloc(stream, size);
+		}
+		len += sprintf(&stream[len], "%s[", i ? "," : "");
+		for (int b = 0; b < BLOCKS; ++b) {
+			len += sprintf(&stream[len], "%s{\"name\":\"block%d\","
+				"\"instance\":\"%d\",\"full_text\":\"value \\u00e9 %d\","
+				"\"color\":\"#%06x\",\"urgent\":%s,\"separator\":true,"
+				"\"separator_block_width\":9,\"markup\":\"none\"}",
+				b ? "," : "", b, b, i * BLOCKS + b, (i * 7919) & 0xffffff,
+				(i + b) % 17 ? "false" : "true");
+		}
+		len += sprintf(&stream[len], "]\n");
+		ends[i] = len;
+	}
+	return stream;
+}
+
+static size_t bench_parser(const char *stream, const size_t *ends) {
+	size_t checksum = 0;
+	struct i3bar_parser parser;
+	i3bar_parser_init(&parser);
+	size_t start = 0;
+	for (int i = 0; i < LINES; ++i) {
+		if (!i3bar_parser_feed(&parser, &stream[start], ends[i] - start)) {
+			fprintf(stderr, "i3bar_parser failed on line %d\n", i);
+			exit(1);
+		}
+		start = ends[i];
+		struct i3bar_line *line = i3bar_parser_take_line(&parser);
+		for (size_t b = 0; line && b < line->len; ++b) {
+			for (int f = 0; f < I3BAR_FIELD_COUNT; ++f) {
+				const char *text = i3bar_value_string(line,
+						&line->blocks[b].fields[f]);
+				checksum += text ? strlen(text) : 0;
+			}
+		}
+	}
+	i3bar_parser_finish(&parser);
+	return checksum;
+}
+
+// What swaybar did with json-c: parse each line, then look up every field
+static size_t bench_jsonc(const char *stream, const size_t *ends) {
+	size_t checksum = 0;
+	struct json_tokener *tokener = json_tokener_new_ex(256);
+	size_t start = 2; // after the opening bracket
+	for (int i = 0; i < LINES; ++i) {
+		const char *line = &stream[start];
+		if (*line == ',') {
+			++line;
+		}
+		json_object *array = json_tokener_parse_ex(tokener, line,
+				&stream[ends[i]] - line);
+		if (json_tokener_get_error(tokener) != json_tokener_success) {
+			fprintf(stderr, "json-c failed on line %d\n", i);
+			exit(1);
+		}
+		json_tokener_reset(tokener);
+		start = ends[i];
+		for (size_t b = 0; b < json_object_array_length(array); ++b) {
+			json_object *block = json_object_array_get_idx(array, b);
+			for (size_t f = 0; f < I3BAR_FIELD_COUNT; ++f) {
+				json_object *value;
+				if (json_object_object_get_ex(block, field_names[f], &value)) {
+					const char *text = json_object_get_string(value);
+					checksum += text ? strlen(text) : 0;
+				}
+			}
+		}
+		json_object_put(array);
+	}
+	json_tokener_free(tokener);
+	return checksum;
+}
+
+int main(void) {
+	size_t *ends = calloc(LINES, sizeof(size_t));
+	char *stream = generate_stream(ends);
+	double mib = ends[LINES - 1] / (1024.0 * 1024.0);
+
+	double start = now();
+	size_t parser_sum = bench_parser(stream, ends);
+	double parser_time = now() - start;
+
+	start = now();
+	size_t jsonc_sum = bench_jsonc(stream, ends);
+	double jsonc_time = now() - start;
+
+	printf("%d lines of %d blocks, %.1f MiB\n", LINES, BLOCKS, mib);
+	printf("i3bar_parser: %.1f ms, %.1f MiB/s\n",
+			parser_time * 1000, mib / parser_time);
+	printf("json-c:       %.1f ms, %.1f MiB/s\n",
+			jsonc_time * 1000, mib / jsonc_time);
+	printf("speedup:      %.2fx\n", jsonc_time / parser_time);
+
+	free(stream);
+	free(ends);
+	if (parser_sum != jsonc_sum) {
+		// Both must have seen the same text
+		fprintf(stderr, "checksums differ: %zu != %zu\n",
+				parser_sum, jsonc_sum);
+		return 1;
+	}
+	return 0;
+}
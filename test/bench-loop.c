@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 200809L
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "loop.h"
+
+// Stays below the usual limit of 1024 open files
+#define PIPES 400
+#define ROUNDS 200000
+#define TIMERS 20000
+
+static struct loop *loop;
+static int pipes[PIPES][2];
+static size_t fd_calls = 0;
+static size_t timer_calls = 0;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fd_callback(int fd, short mask, void *data) {
+	char buf[1];
+	if (read(fd, buf, sizeof(buf)) == 1) {
+		++fd_calls;
+	}
+}
+
+static void timer_callback(void *data) {
+	++timer_calls;
+}
+
+// A permutation of 0..TIMERS-1, so timers aren't removed in heap order
+static int shuffled(int i) {
+	return (int)((i * 7919L) % TIMERS);
+}
+
+/**
+ * One fd out of many becomes readable per poll, with many timers pending
+ * which are not due yet.
+ */
+static void bench_fds(void) {
+	static struct loop_timer *pending[TIMERS];
+	for (int i = 0; i < TIMERS; ++i) {
+		pending[i] = loop_add_timer(loop, 3600 * 1000 + shuffled(i),
+				timer_callback, NULL);
+	}
+
+	double start = now();
+	for (int i = 0; i < ROUNDS; ++i) {
+		if (write(pipes[i % PIPES][1], "x", 1) != 1) {
+			perror("write");
+			exit(1);
+		}
+		loop_poll(loop);
+	}
+	double elapsed = now() - start;
+	printf("fd dispatch, %d fds and %d timers: %.3f us per poll\n",
+			PIPES, TIMERS, elapsed * 1e6 / ROUNDS);
+
+	for (int i = 0; i < TIMERS; ++i) {
+		loop_remove_timer(loop, pending[i]);
+	}
+}
+
+static void bench_timer_add_remove(void) {
+	static struct loop_timer *timers[TIMERS];
+	double start = now();
+	for (int i = 0; i < TIMERS; ++i) {
+		timers[i] = loop_add_timer(loop, 1000 + shuffled(i),
+				timer_callback, NULL);
+	}
+	for (int i = 0; i < TIMERS; ++i) {
+		loop_remove_timer(loop, timers[shuffled(i)]);
+	}
+	double elapsed = now() - start;
+	printf("timer add and remove, %d timers: %.3f us per timer\n",
+			TIMERS, elapsed * 1e6 / TIMERS);
+}
+
+static void bench_timer_dispatch(void) {
+	double start = now();
+	for (int i = 0; i < TIMERS; ++i) {
+		loop_add_timer(loop, 0, timer_callback, NULL);
+	}
+	while (timer_calls < TIMERS) {
+		loop_poll(loop);
+	}
+	double elapsed = now() - start;
+	printf("timer dispatch, %d due timers: %.3f us per timer\n",
+			TIMERS, elapsed * 1e6 / TIMERS);
+}
+
+int main(void) {
+	loop = loop_create();
+	for (int i = 0; i < PIPES; ++i) {
+		if (pipe(pipes[i]) == -1) {
+			perror("pipe");
+			return 1;
+		}
+		loop_add_fd(loop, pipes[i][0], POLLIN, fd_callback, NULL);
+	}
+
+	bench_fds();
+	bench_timer_add_remove();
+	bench_timer_dispatch();
+
+	for (int i = 0; i < PIPES; ++i) {
+		loop_remove_fd(loop, pipes[i][0]);
+		close(pipes[i][0]);
+		close(pipes[i][1]);
+	}
+	loop_destroy(loop);
+
+	if (fd_calls != ROUNDS || timer_calls != TIMERS) {
+		fprintf(stderr, "expected %d fd and %d timer callbacks, got %zu and %zu\n",
+				ROUNDS, TIMERS, fd_calls, timer_calls);
+		return 1;
+	}
+	return 0;
+}
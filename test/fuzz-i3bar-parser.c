@@ -0,0 +1,40 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "swaybar/i3bar_parser.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/**
+ * Feeds the input to a parser in chunks, the first byte giving their size,
+ * and reads every field of the status lines it completes.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	if (size == 0) {
+		return 0;
+	}
+	size_t chunk = data[0] ? data[0] : size;
+	++data;
+	--size;
+
+	struct i3bar_parser parser;
+	i3bar_parser_init(&parser);
+	for (size_t pos = 0; pos < size; pos += chunk) {
+		size_t len = size - pos < chunk ? size - pos : chunk;
+		if (!i3bar_parser_feed(&parser, (const char *)&data[pos], len)) {
+			break;
+		}
+		struct i3bar_line *line = i3bar_parser_take_line(&parser);
+		for (size_t i = 0; line && i < line->len; ++i) {
+			for (int f = 0; f < I3BAR_FIELD_COUNT; ++f) {
+				struct i3bar_value *value = &line->blocks[i].fields[f];
+				i3bar_value_string(line, value);
+				i3bar_value_int(line, value);
+				if (value->type != I3BAR_VALUE_NONE) {
+					i3bar_value_is_int(line, value);
+				}
+			}
+		}
+	}
+	i3bar_parser_finish(&parser);
+	return 0;
+}
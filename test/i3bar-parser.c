@@ -0,0 +1,344 @@
+#define _POSIX_C_SOURCE 200809L
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "swaybar/i3bar_parser.h"
+
+static int failures = 0;
+
+#define check(cond) do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", \
+					__FILE__, __LINE__, #cond); \
+			++failures; \
+		} \
+	} while (0)
+
+/**
+ * Serializes a status line as "field=value;" for each field that is set and
+ * "|" after each block, so that lines can be compared as strings.
+ */
+static char *describe_line(struct i3bar_line *line) {
+	size_t size = 64;
+	for (size_t i = 0; i < line->len; ++i) {
+		size += I3BAR_FIELD_COUNT * 8 + 1;
+	}
+	size += line->strings_len;
+	char *out = calloc(1, size);
+	size_t len = 0;
+	for (size_t i = 0; i < line->len; ++i) {
+		struct i3bar_parsed_block *block = &line->blocks[i];
+		for (int f = 0; f < I3BAR_FIELD_COUNT; ++f) {
+			const char *text = i3bar_value_string(line, &block->fields[f]);
+			if (text) {
+				len += snprintf(&out[len], size - len, "%d=%s;", f, text);
+			}
+		}
+		len += snprintf(&out[len], size - len, "|");
+	}
+	return out;
+}
+
+/**
+ * Feeds the input in chunks of at most chunk bytes, and returns the
+ * description of every status line taken after a chunk, each followed by a
+ * record separator, or NULL if the input is invalid.
+ */
+static char *parse_chunked(const char *input, size_t len, size_t chunk) {
+	struct i3bar_parser parser;
+	i3bar_parser_init(&parser);
+	char *out = strdup("");
+	for (size_t pos = 0; pos < len; pos += chunk) {
+		size_t n = len - pos < chunk ? len - pos : chunk;
+		if (!i3bar_parser_feed(&parser, &input[pos], n)) {
+			free(out);
+			i3bar_parser_finish(&parser);
+			return NULL;
+		}
+		struct i3bar_line *line = i3bar_parser_take_line(&parser);
+		if (line) {
+			char *desc = describe_line(line);
+			char *joined = malloc(strlen(out) + strlen(desc) + 2);
+			sprintf(joined, "%s%s\x1e", out, desc);
+			free(out);
+			free(desc);
+			out = joined;
+		}
+	}
+	i3bar_parser_finish(&parser);
+	return out;
+}
+
+// The description of the last status line of a parse, NULL if there is none
+static const char *last_line(const char *out) {
+	static char buf[4096];
+	if (!out || !*out) {
+		return NULL;
+	}
+	size_t len = strlen(out) - 1; // without the final separator
+	size_t start = len;
+	while (start > 0 && out[start - 1] != '\x1e') {
+		--start;
+	}
+	snprintf(buf, sizeof(buf), "%.*s", (int)(len - start), &out[start]);
+	return buf;
+}
+
+static bool parses(const char *input) {
+	char *out = parse_chunked(input, strlen(input), strlen(input) + 1);
+	free(out);
+	return out != NULL;
+}
+
+static void expect_last_line(const char *input, const char *expected) {
+	char *out = parse_chunked(input, strlen(input), strlen(input) + 1);
+	const char *last = last_line(out);
+	if (!last || strcmp(last, expected) != 0) {
+		fprintf(stderr, "input: %s\nexpected: %s\ngot: %s\n",
+				input, expected, last ? last : "(none)");
+		++failures;
+	}
+	free(out);
+}
+
+static const char *stream =
+	"[\n"
+	"[{\"full_text\":\"a\",\"name\":\"x\"},{\"full_text\":\"b\"}],\n"
+	"[{\"full_text\":\"caf\\u00e9 \\\"q\\\"\",\"urgent\":true,"
+		"\"min_width\":100,\"separator\":false,\"color\":null,"
+		"\"unknown\":{\"nested\":[1,\"}]\",{}]},"
+		"\"instance\":\"i\"}],\n"
+	"[]\n"
+	",[{\"short_text\" : \"s\" , \"align\" : \"center\"}]\n";
+
+static void test_chunk_splits(void) {
+	size_t len = strlen(stream);
+	char *whole = parse_chunked(stream, len, len);
+	check(whole != NULL);
+	char expected[4096];
+	snprintf(expected, sizeof(expected), "%s", last_line(whole));
+	check(strcmp(expected, "1=s;4=center;|") == 0);
+
+	// Every status line shows up when fed one byte at a time
+	char *bytes = parse_chunked(stream, len, 1);
+	check(bytes && strcmp(bytes,
+		"0=a;6=x;|0=b;|\x1e"
+		"0=caf\xc3\xa9 \"q\";3=100;5=true;7=i;8=false;|\x1e"
+		"\x1e"
+		"1=s;4=center;|\x1e") == 0);
+	free(bytes);
+
+	// Splitting the input anywhere gives the same result
+	for (size_t split = 1; split < len; ++split) {
+		struct i3bar_parser parser;
+		i3bar_parser_init(&parser);
+		check(i3bar_parser_feed(&parser, stream, split));
+		struct i3bar_line *line = i3bar_parser_take_line(&parser);
+		char *desc = line ? describe_line(line) : NULL;
+		check(i3bar_parser_feed(&parser, &stream[split], len - split));
+		if ((line = i3bar_parser_take_line(&parser))) {
+			free(desc);
+			desc = describe_line(line);
+		}
+		if (!desc || strcmp(desc, expected) != 0) {
+			fprintf(stderr, "split at %zu: got %s\n", split,
+					desc ? desc : "(none)");
+			++failures;
+		}
+		free(desc);
+		i3bar_parser_finish(&parser);
+	}
+
+	// And so does every chunk size
+	for (size_t chunk = 1; chunk <= len; ++chunk) {
+		char *out = parse_chunked(stream, len, chunk);
+		const char *last = last_line(out);
+		check(last && strcmp(last, expected) == 0);
+		free(out);
+	}
+	free(whole);
+}
+
+static void test_values(void) {
+	const char *input = "[[{\"min_width\":12.5e1,\"separator_block_width\":9,"
+		"\"urgent\":false,\"border\":\"3\"}]";
+	struct i3bar_parser parser;
+	i3bar_parser_init(&parser);
+	check(i3bar_parser_feed(&parser, input, strlen(input)));
+	struct i3bar_line *line = i3bar_parser_take_line(&parser);
+	check(line && line->len == 1);
+	if (line && line->len == 1) {
+		struct i3bar_value *fields = line->blocks[0].fields;
+		check(fields[I3BAR_MIN_WIDTH].type == I3BAR_VALUE_NUMBER);
+		check(!i3bar_value_is_int(line, &fields[I3BAR_MIN_WIDTH]));
+		check(i3bar_value_int(line, &fields[I3BAR_MIN_WIDTH]) == 125);
+		check(i3bar_value_is_int(line,
+				&fields[I3BAR_SEPARATOR_BLOCK_WIDTH]));
+		check(i3bar_value_int(line, &fields[I3BAR_URGENT]) == 0);
+		check(fields[I3BAR_BORDER].type == I3BAR_VALUE_STRING);
+		check(i3bar_value_int(line, &fields[I3BAR_BORDER]) == 3);
+		check(fields[I3BAR_FULL_TEXT].type == I3BAR_VALUE_NONE);
+		check(i3bar_value_string(line, &fields[I3BAR_FULL_TEXT]) == NULL);
+	}
+	check(i3bar_parser_take_line(&parser) == NULL);
+	i3bar_parser_finish(&parser);
+}
+
+static void test_escapes(void) {
+	expect_last_line("[[{\"full_text\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"}]",
+		"0=\"\\/\b\f\n\r\t;|");
+	// Surrogate pairs, including one split across chunks below
+	expect_last_line("[[{\"full_text\":\"\\ud83d\\ude00\"}]",
+		"0=\xf0\x9f\x98\x80;|");
+	// Lone surrogates become replacement characters
+	expect_last_line("[[{\"full_text\":\"\\ud83dx\"}]", "0=\xef\xbf\xbdx;|");
+	expect_last_line("[[{\"full_text\":\"\\ude00\"}]", "0=\xef\xbf\xbd;|");
+	expect_last_line("[[{\"full_text\":\"\\ud83d\\ud83d\\ude00\"}]",
+		"0=\xef\xbf\xbd\xf0\x9f\x98\x80;|");
+	expect_last_line("[[{\"full_text\":\"\\ud83d\"}]", "0=\xef\xbf\xbd;|");
+	expect_last_line("[[{\"full_text\":\"\\ud83d\\n\"}]",
+		"0=\xef\xbf\xbd\n;|");
+	// Raw UTF-8 is passed through
+	expect_last_line("[[{\"full_text\":\"\xc3\xa9\"}]", "0=\xc3\xa9;|");
+
+	const char *split = "[[{\"full_text\":\"\\ud83d\\ude00\"}]";
+	char *out = parse_chunked(split, strlen(split), 1);
+	const char *last = last_line(out);
+	check(last && strcmp(last, "0=\xf0\x9f\x98\x80;|") == 0);
+	free(out);
+
+	check(!parses("[[{\"full_text\":\"\\x\"}]"));
+	check(!parses("[[{\"full_text\":\"\\u12g4\"}]"));
+}
+
+static void test_depth(void) {
+	// The stream, line and block take three levels
+	char input[I3BAR_PARSER_MAX_DEPTH * 2 + 64];
+	for (int extra = 0; extra <= 1; ++extra) {
+		int nested = I3BAR_PARSER_MAX_DEPTH - 3 + extra;
+		size_t len = 0;
+		len += sprintf(&input[len], "[[{\"unknown\":");
+		for (int i = 0; i < nested; ++i) {
+			input[len++] = '[';
+		}
+		for (int i = 0; i < nested; ++i) {
+			input[len++] = ']';
+		}
+		len += sprintf(&input[len], ",\"full_text\":\"x\"}]");
+		if (extra) {
+			check(!parses(input));
+		} else {
+			expect_last_line(input, "0=x;|");
+		}
+	}
+}
+
+static void test_long_tokens(void) {
+	char input[1024];
+	char key[I3BAR_PARSER_TOKEN_MAX * 2];
+	memset(key, 'k', sizeof(key) - 1);
+	key[sizeof(key) - 1] = '\0';
+	// Overlong keys are skipped along with their value
+	snprintf(input, sizeof(input),
+		"[[{\"%s\":\"v\",\"full_text\":\"x\"}]", key);
+	expect_last_line(input, "0=x;|");
+	// Even if they start with a field name
+	memcpy(key, "full_text", strlen("full_text"));
+	snprintf(input, sizeof(input), "[[{\"%s\":\"v\"}]", key);
+	expect_last_line(input, "|");
+
+	// Overlong strings are kept
+	char text[4096];
+	memset(text, 't', sizeof(text) - 1);
+	text[sizeof(text) - 1] = '\0';
+	char *long_input = malloc(sizeof(text) + 64);
+	sprintf(long_input, "[[{\"full_text\":\"%s\"}]", text);
+	char *out = parse_chunked(long_input, strlen(long_input), 7);
+	check(out && strlen(out) == strlen(text) + strlen("0=;|\n"));
+	free(out);
+	free(long_input);
+
+	// Overlong scalars are rejected
+	char number[I3BAR_PARSER_TOKEN_MAX * 2];
+	memset(number, '1', sizeof(number) - 1);
+	number[sizeof(number) - 1] = '\0';
+	snprintf(input, sizeof(input), "[[{\"min_width\":%s}]", number);
+	check(!parses(input));
+}
+
+static void test_invalid(void) {
+	check(!parses("{}"));
+	check(!parses("[{]"));
+	check(!parses("[[}"));
+	check(!parses("[[{\"full_text\"}]"));
+	check(!parses("[[{\"full_text\":}]"));
+	check(!parses("[[{\"full_text\":\"a\",}]"));
+	check(!parses("[[{\"full_text\":\"a\"} {}]"));
+	check(!parses("[[{\"full_text\":nul}]"));
+	check(!parses("[[{\"full_text\":x1}]"));
+	check(!parses("[[]]["));
+	// Values other than status lines are ignored
+	check(parses("[\"a\",1,{\"b\":2}]"));
+	check(!parses("[[{\"full_text\":\"a\"}]\xff"));
+	check(!parses("[[{\"min_width\":1\xe9}]"));
+	check(!parses("[[{\"min_width\":\xc3\xa9}]"));
+	check(parses("  [ [ ] , [ { } ] ] "));
+}
+
+static void test_numbers(void) {
+	const char *valid[] = {
+		"0", "-0", "7", "-12", "1.5", "-0.25", "1e3", "1E+3", "2.5e-2",
+	};
+	for (size_t i = 0; i < sizeof(valid) / sizeof(*valid); ++i) {
+		char input[64];
+		snprintf(input, sizeof(input), "[[{\"border_top\":%s}]", valid[i]);
+		if (!parses(input)) {
+			fprintf(stderr, "rejected number %s\n", valid[i]);
+			++failures;
+		}
+	}
+	// strtod takes all of these, JSON doesn't
+	const char *invalid[] = {
+		"-nan", "nan", "-inf", "inf", "-infinity", "-0x1f", "0x1f", "+1",
+		"01", "-", "1.", ".5", "1e", "1e+", "-.5", "1.e3",
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i) {
+		char input[64];
+		snprintf(input, sizeof(input),
+			"[[{\"full_text\":\"x\",\"border_top\":%s}]", invalid[i]);
+		if (parses(input)) {
+			fprintf(stderr, "accepted number %s\n", invalid[i]);
+			++failures;
+		}
+	}
+
+	const char *input = "[[{\"border_top\":-3e9,\"border_left\":4e9}]";
+	struct i3bar_parser parser;
+	i3bar_parser_init(&parser);
+	check(i3bar_parser_feed(&parser, input, strlen(input)));
+	struct i3bar_line *line = i3bar_parser_take_line(&parser);
+	check(line && line->len == 1);
+	if (line && line->len == 1) {
+		struct i3bar_value *fields = line->blocks[0].fields;
+		check(i3bar_value_int(line, &fields[I3BAR_BORDER_TOP]) == INT_MIN);
+		check(i3bar_value_int(line, &fields[I3BAR_BORDER_LEFT]) == INT_MAX);
+	}
+	i3bar_parser_finish(&parser);
+}
+
+int main(void) {
+	test_chunk_splits();
+	test_values();
+	test_escapes();
+	test_depth();
+	test_long_tokens();
+	test_invalid();
+	test_numbers();
+	if (failures) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	return 0;
+}